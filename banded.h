@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "matrix.h"
+#include "thread_pool.h"
+#include "vector_ops.h"
+
+// Ленточные матрицы (ширина ленты kl под диагональю и ku над ней) и
+// трёхдиагональные системы: LU-разложение ленты за O(n kl (kl + ku))
+// вместо O(n^3), метод прогонки и циклическая редукция.
+
+// Ширина ленты: наибольшее i - j (нижняя) и j - i (верхняя) по ненулевым элементам
+inline int lower_bandwidth(ConstMatrixView A)
+{
+    int kl = 0;
+    for (int i = 0; i < A.rows(); i++) {
+        const double *Ai = A[i];
+        for (int j = 0; j < i - kl; j++) {
+            if (Ai[j] != 0) {
+                kl = i - j;
+                break;
+            }
+        }
+    }
+    return kl;
+}
+
+inline int upper_bandwidth(ConstMatrixView A)
+{
+    int ku = 0;
+    for (int i = 0; i < A.rows(); i++) {
+        const double *Ai = A[i];
+        for (int j = A.cols() - 1; j > i + ku; j--) {
+            if (Ai[j] != 0) {
+                ku = j - i;
+                break;
+            }
+        }
+    }
+    return ku;
+}
+
+// Ленточная матрица n x n по строкам: в строке i хранятся столбцы
+// [i - kl, i + ku + kl]. Лишние kl столбцов справа - место под
+// заполнение U при перестановках строк (как в dgbtrf из LAPACK).
+class BandMatrix
+{
+public:
+    BandMatrix() : n_(0), kl_(0), ku_(0) {}
+
+    BandMatrix(int n, int kl, int ku) : n_(n), kl_(kl), ku_(ku), data_(storage_size(n, kl, ku)) {}
+
+    // Копия ленты A; элементы вне ленты должны быть нулевыми
+    BandMatrix(ConstMatrixView A, int kl, int ku) : BandMatrix(A.rows(), kl, ku)
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        for (int i = 0; i < n_; i++) {
+            int j0 = std::max(0, i - kl_), j1 = std::min(n_ - 1, i + ku_);
+            std::copy(A[i] + j0, A[i] + j1 + 1, &(*this)(i, j0));
+        }
+    }
+
+    int size() const { return n_; }
+    int lower() const { return kl_; }
+    int upper() const { return ku_; }
+    // Длина хранимой строки
+    int width() const { return 2 * kl_ + ku_ + 1; }
+
+    // Элемент (i, j), i - kl <= j <= i + ku + kl
+    double &operator()(int i, int j) { return data_[std::size_t(i) * width() + j - i + kl_]; }
+    const double &operator()(int i, int j) const { return data_[std::size_t(i) * width() + j - i + kl_]; }
+
+private:
+    // Размер хранилища; размеры проверяются до выделения памяти
+    static std::size_t storage_size(int n, int kl, int ku)
+    {
+        if (n < 0 || kl < 0 || ku < 0) throw "Incorrect band size";
+        long long width = 2LL * kl + ku + 1;
+        if (width > std::numeric_limits<int>::max()) throw "Incorrect band size";
+        return std::size_t(n) * std::size_t(width);
+    }
+
+    int n_;
+    int kl_;
+    int ku_;
+    std::vector<double> data_;
+};
+
+// LU-разложение ленты на месте с выбором ведущего элемента по столбцу
+// (как dgbtrf): ведущий ищется среди kl + 1 строк, перестановка строк
+// k и ipiv[k] записывается, множители L остаются в столбце k. U
+// занимает до ku + kl диагоналей над главной.
+inline void band_LU_factor(BandMatrix &A, std::vector<int> &ipiv)
+{
+    const VectorKernels &v = vector_kernels();
+    int n = A.size(), kl = A.lower(), ku = A.upper();
+    ipiv.resize(n);
+    for (int k = 0; k < n; k++) {
+        int last = std::min(n - 1, k + kl), jlast = std::min(n - 1, k + ku + kl);
+        int p = k;
+        for (int i = k + 1; i <= last; i++) {
+            if (std::fabs(A(i, k)) > std::fabs(A(p, k))) p = i;
+        }
+        if (A(p, k) == 0) throw "Matrix is singular";
+        ipiv[k] = p;
+        if (p != k) std::swap_ranges(&A(k, k), &A(k, k) + jlast - k + 1, &A(p, k));
+        for (int i = k + 1; i <= last; i++) {
+            double lik = A(i, k) / A(k, k);
+            A(i, k) = lik;
+            if (jlast > k) v.axpy(jlast - k, -lik, &A(k, k + 1), &A(i, k + 1));
+        }
+    }
+}
+
+// Решение A x = b на месте по разложению band_LU_factor
+inline void band_LU_solve(const BandMatrix &LU, const std::vector<int> &ipiv, double *x)
+{
+    const VectorKernels &v = vector_kernels();
+    int n = LU.size(), kl = LU.lower(), ku = LU.upper();
+    for (int k = 0; k < n; k++) {
+        std::swap(x[k], x[ipiv[k]]);
+        for (int i = k + 1; i <= std::min(n - 1, k + kl); i++) x[i] -= LU(i, k) * x[k];
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        int jlast = std::min(n - 1, i + ku + kl);
+        double sum = (jlast > i) ? v.dot(&LU(i, i + 1), x + i + 1, jlast - i) : 0.0;
+        x[i] = (x[i] - sum) / LU(i, i);
+    }
+}
+
+// Ленточное разложение для многократного решения систем
+class BandFactorization
+{
+public:
+    BandFactorization() {}
+
+    BandFactorization(ConstMatrixView A, int kl, int ku) { factor(A, kl, ku); }
+
+    void factor(ConstMatrixView A, int kl, int ku)
+    {
+        lu_ = BandMatrix(A, kl, ku);
+        band_LU_factor(lu_, ipiv_);
+    }
+
+    int size() const { return lu_.size(); }
+    const BandMatrix &lu() const { return lu_; }
+
+    void solve(const std::vector<double> &b, std::vector<double> &x) const
+    {
+        if (int(b.size()) != size()) throw "Matrix and vector sizes doesnt match";
+        x = b;
+        band_LU_solve(lu_, ipiv_, x.data());
+    }
+
+    std::vector<double> solve(const std::vector<double> &b) const
+    {
+        std::vector<double> x;
+        solve(b, x);
+        return x;
+    }
+
+private:
+    BandMatrix lu_;
+    std::vector<int> ipiv_;
+};
+
+// Трёхдиагональная матрица: a - поддиагональ (a[0] не используется),
+// b - диагональ, c - наддиагональ (c[n - 1] не используется)
+struct Tridiagonal
+{
+    std::vector<double> a, b, c;
+
+    Tridiagonal() {}
+
+    explicit Tridiagonal(ConstMatrixView A) : a(A.rows(), 0.0), b(A.rows()), c(A.rows(), 0.0)
+    {
+        int n = A.rows();
+        for (int i = 0; i < n; i++) {
+            b[i] = A[i][i];
+            if (i > 0) a[i] = A[i][i - 1];
+            if (i + 1 < n) c[i] = A[i][i + 1];
+        }
+    }
+
+    int size() const { return int(b.size()); }
+
+    // Строгое диагональное преобладание по строкам: прогонка и циклическая
+    // редукция без перестановок тогда устойчивы
+    bool diagonally_dominant() const
+    {
+        for (int i = 0; i < size(); i++) {
+            double off = (i > 0 ? std::fabs(a[i]) : 0.0) + (i + 1 < size() ? std::fabs(c[i]) : 0.0);
+            if (!(std::fabs(b[i]) > off)) return false;
+        }
+        return true;
+    }
+};
+
+// Метод прогонки (алгоритм Томаса) за O(n), без перестановок
+inline std::vector<double> thomas_solve(const Tridiagonal &T, const std::vector<double> &d)
+{
+    int n = T.size();
+    if (int(d.size()) != n) throw "Matrix and vector sizes doesnt match";
+    std::vector<double> cp(n), x(n);
+    for (int i = 0; i < n; i++) {
+        double denom = (i > 0) ? T.b[i] - T.a[i] * cp[i - 1] : T.b[0];
+        if (denom == 0) throw "Matrix is singular";
+        cp[i] = (i + 1 < n) ? T.c[i] / denom : 0.0;
+        x[i] = (d[i] - (i > 0 ? T.a[i] * x[i - 1] : 0.0)) / denom;
+    }
+    for (int i = n - 2; i >= 0; i--) x[i] -= cp[i] * x[i + 1];
+    return x;
+}
+
+// Уравнений на задачу пула в одном уровне циклической редукции
+const int CYCLIC_REDUCTION_CHUNK = 16384;
+
+// Циклическая редукция: на уровне с шагом s уравнения i = 2s - 1, 4s - 1, ...
+// исключают соседей i - s и i + s и дальше связаны только с i +- 2s.
+// После log2(n) уровней остаётся одно уравнение, затем неизвестные
+// восстанавливаются в обратном порядке. Уравнения одного уровня
+// независимы, поэтому с пулом уровень делится между потоками. Работы
+// примерно вдвое больше, чем у прогонки, так что выигрыш есть только на
+// нескольких потоках и длинных системах. Требует диагонального преобладания.
+inline std::vector<double> cyclic_reduction_solve(const Tridiagonal &T, const std::vector<double> &d, ThreadPool *pool = nullptr)
+{
+    int n = T.size();
+    if (int(d.size()) != n) throw "Matrix and vector sizes doesnt match";
+    std::vector<double> a = T.a, b = T.b, c = T.c, r = d, x(n);
+    if (n == 0) return x;
+    a[0] = 0, c[n - 1] = 0;
+    double *pa = a.data(), *pb = b.data(), *pc = c.data(), *pr = r.data(), *px = x.data();
+
+    // Вызывает f(i) для i = first, first + step, ... < n, с пулом - кусками
+    auto for_level = [n, pool](int first, int step, auto f) {
+        int count = first < n ? (n - 1 - first) / step + 1 : 0;
+        if (!pool || count < 2 * CYCLIC_REDUCTION_CHUNK) {
+            for (int i = first; i < n; i += step) f(i);
+            return;
+        }
+        for (int t0 = 0; t0 < count; t0 += CYCLIC_REDUCTION_CHUNK) {
+            int t1 = std::min(count, t0 + CYCLIC_REDUCTION_CHUNK);
+            pool->submit([=] {
+                for (int t = t0; t < t1; t++) f(first + t * step);
+            });
+        }
+        pool->wait();
+    };
+
+    int s = 1;
+    for (; 2 * s <= n; s *= 2) {
+        for_level(2 * s - 1, 2 * s, [=](int i) {
+            int im = i - s, ip = i + s;
+            double alpha = -pa[i] / pb[im];
+            double gamma = ip < n ? -pc[i] / pb[ip] : 0.0;
+            pb[i] += alpha * pc[im] + (ip < n ? gamma * pa[ip] : 0.0);
+            pr[i] += alpha * pr[im] + (ip < n ? gamma * pr[ip] : 0.0);
+            pa[i] = alpha * pa[im];
+            pc[i] = ip < n ? gamma * pc[ip] : 0.0;
+        });
+    }
+    x[s - 1] = r[s - 1] / b[s - 1];
+    for (s /= 2; s >= 1; s /= 2) {
+        for_level(s - 1, 2 * s, [=](int i) {
+            double sum = pr[i] - (i - s >= 0 ? pa[i] * px[i - s] : 0.0) - (i + s < n ? pc[i] * px[i + s] : 0.0);
+            px[i] = sum / pb[i];
+        });
+    }
+    return x;
+}
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "matrix.h"
+#include "vector_ops.h"
+
+// Пакетное LU-разложение множества независимых маленьких систем (n от
+// единиц до нескольких десятков). Матрицы хранятся вперемешку (SoA):
+// группа из BATCH_LANES систем занимает одну строку буфера, и элемент
+// (i, j) всех систем группы - это BATCH_LANES чисел подряд. Каждый шаг
+// исключения становится одной векторной операцией сразу над всеми
+// системами группы, а не циклом по короткой строке одной матрицы, и на
+// систему не выделяется память.
+
+// Систем в группе: 8 double - один регистр AVX-512 или два AVX2
+const int BATCH_LANES = 8;
+// Размеры n <= BATCH_FIXED_MAX раскладываются специализациями шаблона
+// с известными при компиляции границами циклов
+const int BATCH_FIXED_MAX = 16;
+
+// count матриц n x n в чередующемся формате: элемент (i, j) системы s
+// лежит в строке s / BATCH_LANES буфера на месте
+// (i * n + j) * BATCH_LANES + s % BATCH_LANES. Незанятые места последней
+// группы заполнены единичными матрицами, чтобы разложение их не замечало.
+class MatrixBatch
+{
+public:
+    MatrixBatch() : n_(0), count_(0) {}
+
+    MatrixBatch(int n, int count)
+        : n_(n), count_(count), data_((count + BATCH_LANES - 1) / BATCH_LANES, n * n * BATCH_LANES)
+    {
+        if (n < 1 || count < 0) throw "Incorrect batch size";
+        for (int s = count; s < groups() * BATCH_LANES; ++s) {
+            for (int i = 0; i < n; ++i) (*this)(s, i, i) = 1;
+        }
+    }
+
+    int size() const { return n_; }
+    int count() const { return count_; }
+    int groups() const { return data_.rows(); }
+    int stride() const { return data_.stride(); }
+
+    double &operator()(int s, int i, int j) { return data_[s / BATCH_LANES][(i * n_ + j) * BATCH_LANES + s % BATCH_LANES]; }
+    double operator()(int s, int i, int j) const { return data_[s / BATCH_LANES][(i * n_ + j) * BATCH_LANES + s % BATCH_LANES]; }
+
+    // Начало группы g: BATCH_LANES матриц вперемешку
+    double *group(int g) { return data_[g]; }
+    const double *group(int g) const { return data_[g]; }
+
+    // Запись и чтение матрицы системы s в обычном виде
+    void set(int s, ConstMatrixView A)
+    {
+        if (A.rows() != n_ || A.cols() != n_) throw "Matrix sizes doesnt match";
+        for (int i = 0; i < n_; ++i) {
+            for (int j = 0; j < n_; ++j) (*this)(s, i, j) = A[i][j];
+        }
+    }
+
+    Matrix get(int s) const
+    {
+        Matrix A(n_, n_);
+        for (int i = 0; i < n_; ++i) {
+            for (int j = 0; j < n_; ++j) A[i][j] = (*this)(s, i, j);
+        }
+        return A;
+    }
+
+private:
+    int n_;
+    int count_;
+    Matrix data_;
+};
+
+// count векторов длины n в том же формате: элемент i системы s лежит в
+// строке s / BATCH_LANES на месте i * BATCH_LANES + s % BATCH_LANES
+class VectorBatch
+{
+public:
+    VectorBatch() : n_(0), count_(0) {}
+
+    VectorBatch(int n, int count) : n_(n), count_(count), data_((count + BATCH_LANES - 1) / BATCH_LANES, n * BATCH_LANES)
+    {
+        if (n < 1 || count < 0) throw "Incorrect batch size";
+    }
+
+    int size() const { return n_; }
+    int count() const { return count_; }
+    int groups() const { return data_.rows(); }
+    int stride() const { return data_.stride(); }
+
+    double &operator()(int s, int i) { return data_[s / BATCH_LANES][i * BATCH_LANES + s % BATCH_LANES]; }
+    double operator()(int s, int i) const { return data_[s / BATCH_LANES][i * BATCH_LANES + s % BATCH_LANES]; }
+
+    double *group(int g) { return data_[g]; }
+    const double *group(int g) const { return data_[g]; }
+
+    void set(int s, const std::vector<double> &v)
+    {
+        if (int(v.size()) != n_) throw "Vectors sizes doesnt match";
+        for (int i = 0; i < n_; ++i) (*this)(s, i) = v[i];
+    }
+
+    std::vector<double> get(int s) const
+    {
+        std::vector<double> v(n_);
+        for (int i = 0; i < n_; ++i) v[i] = (*this)(s, i);
+        return v;
+    }
+
+private:
+    int n_;
+    int count_;
+    Matrix data_;
+};
+
+namespace batched_detail
+{
+
+// Векторы GCC на все системы группы. Ядра ниже встраиваются (always_inline)
+// в функции с атрибутом target, поэтому одни и те же операции над BatchLanes
+// компилируются в SSE2, AVX2 или AVX-512 в зависимости от варианта.
+typedef double BatchLanes __attribute__((vector_size(BATCH_LANES * sizeof(double))));
+typedef long long BatchIndices __attribute__((vector_size(BATCH_LANES * sizeof(long long))));
+
+// Разложение группы на месте с выбором ведущего элемента по столбцу
+// отдельно в каждой системе: PA = LU, упаковано как в LU_factor_panel.
+// piv[k * BATCH_LANES + l] - строка, переставленная с k-й на шаге k в
+// системе l (как ipiv в LAPACK). При N = 0 размер берётся из n.
+template<int N>
+inline __attribute__((always_inline)) void factor_group(double *a, int *piv, int n)
+{
+    const int m = N ? N : n;
+    BatchLanes *A = reinterpret_cast<BatchLanes *>(a);
+    for (int k = 0; k < m; ++k) {
+        BatchLanes *Ak = A + k * m;
+        BatchLanes max = Ak[k] < 0 ? -Ak[k] : Ak[k];
+        BatchIndices p = BatchIndices{} + k;
+        for (int i = k + 1; i < m; ++i) {
+            BatchLanes v = A[i * m + k];
+            v = v < 0 ? -v : v;
+            auto greater = v > max;
+            max = greater ? v : max;
+            p = greater ? BatchIndices{} + i : p;
+        }
+        // Перестановки у систем группы разные, поэтому строки меняются поэлементно
+        for (int l = 0; l < BATCH_LANES; ++l) {
+            if (max[l] == 0) throw "Matrix is singular";
+            int pl = int(p[l]);
+            piv[k * BATCH_LANES + l] = pl;
+            if (pl == k) continue;
+            for (int j = 0; j < m; ++j) std::swap(a[(k * m + j) * BATCH_LANES + l], a[(pl * m + j) * BATCH_LANES + l]);
+        }
+        for (int i = k + 1; i < m; ++i) {
+            BatchLanes *Ai = A + i * m;
+            BatchLanes lik = Ai[k] / Ak[k];
+            Ai[k] = lik;
+            for (int j = k + 1; j < m; ++j) Ai[j] -= lik * Ak[j];
+        }
+    }
+}
+
+// Решение систем группы по её разложению, b перезаписывается решением
+template<int N>
+inline __attribute__((always_inline)) void solve_group(const double *lu, const int *piv, double *b, int n)
+{
+    const int m = N ? N : n;
+    for (int k = 0; k < m; ++k) {
+        for (int l = 0; l < BATCH_LANES; ++l) {
+            int pl = piv[k * BATCH_LANES + l];
+            if (pl != k) std::swap(b[k * BATCH_LANES + l], b[pl * BATCH_LANES + l]);
+        }
+    }
+    const BatchLanes *LU = reinterpret_cast<const BatchLanes *>(lu);
+    BatchLanes *B = reinterpret_cast<BatchLanes *>(b);
+    for (int i = 1; i < m; ++i) {
+        BatchLanes sum = B[i];
+        for (int j = 0; j < i; ++j) sum -= LU[i * m + j] * B[j];
+        B[i] = sum;
+    }
+    for (int i = m - 1; i >= 0; --i) {
+        BatchLanes sum = B[i];
+        for (int j = i + 1; j < m; ++j) sum -= LU[i * m + j] * B[j];
+        B[i] = sum / LU[i * m + i];
+    }
+}
+
+// Группы [first, last): a - начало буфера матриц со страйдом a_stride,
+// piv - n * BATCH_LANES элементов на группу
+template<int N>
+inline __attribute__((always_inline)) void factor_groups(double *a, int a_stride, int *piv, int n, int first, int last)
+{
+    for (int g = first; g < last; ++g) {
+        factor_group<N>(a + std::ptrdiff_t(g) * a_stride, piv + std::ptrdiff_t(g) * n * BATCH_LANES, n);
+    }
+}
+
+template<int N>
+inline __attribute__((always_inline)) void solve_groups(const double *lu, int lu_stride, const int *piv,
+                                                        double *b, int b_stride, int n, int first, int last)
+{
+    for (int g = first; g < last; ++g) {
+        solve_group<N>(lu + std::ptrdiff_t(g) * lu_stride, piv + std::ptrdiff_t(g) * n * BATCH_LANES,
+                       b + std::ptrdiff_t(g) * b_stride, n);
+    }
+}
+
+// Выбор специализации по n: N = 1 .. BATCH_FIXED_MAX, иначе общий вариант
+template<int N>
+inline __attribute__((always_inline)) void factor_groups_fixed(double *a, int a_stride, int *piv, int n, int first, int last)
+{
+    if constexpr (N > BATCH_FIXED_MAX) factor_groups<0>(a, a_stride, piv, n, first, last);
+    else if (n == N) factor_groups<N>(a, a_stride, piv, n, first, last);
+    else factor_groups_fixed<N + 1>(a, a_stride, piv, n, first, last);
+}
+
+template<int N>
+inline __attribute__((always_inline)) void solve_groups_fixed(const double *lu, int lu_stride, const int *piv,
+                                                              double *b, int b_stride, int n, int first, int last)
+{
+    if constexpr (N > BATCH_FIXED_MAX) solve_groups<0>(lu, lu_stride, piv, b, b_stride, n, first, last);
+    else if (n == N) solve_groups<N>(lu, lu_stride, piv, b, b_stride, n, first, last);
+    else solve_groups_fixed<N + 1>(lu, lu_stride, piv, b, b_stride, n, first, last);
+}
+
+inline void factor_scalar(double *a, int a_stride, int *piv, int n, int first, int last)
+{
+    factor_groups_fixed<1>(a, a_stride, piv, n, first, last);
+}
+
+inline void solve_scalar(const double *lu, int lu_stride, const int *piv, double *b, int b_stride, int n, int first, int last)
+{
+    solve_groups_fixed<1>(lu, lu_stride, piv, b, b_stride, n, first, last);
+}
+
+#ifdef VECTOR_OPS_X86
+
+__attribute__((target("avx2,fma"))) inline void factor_avx2(double *a, int a_stride, int *piv, int n, int first, int last)
+{
+    factor_groups_fixed<1>(a, a_stride, piv, n, first, last);
+}
+
+__attribute__((target("avx2,fma"))) inline void solve_avx2(const double *lu, int lu_stride, const int *piv,
+                                                           double *b, int b_stride, int n, int first, int last)
+{
+    solve_groups_fixed<1>(lu, lu_stride, piv, b, b_stride, n, first, last);
+}
+
+__attribute__((target("avx512f"))) inline void factor_avx512(double *a, int a_stride, int *piv, int n, int first, int last)
+{
+    factor_groups_fixed<1>(a, a_stride, piv, n, first, last);
+}
+
+__attribute__((target("avx512f"))) inline void solve_avx512(const double *lu, int lu_stride, const int *piv,
+                                                            double *b, int b_stride, int n, int first, int last)
+{
+    solve_groups_fixed<1>(lu, lu_stride, piv, b, b_stride, n, first, last);
+}
+
+#endif
+
+} // namespace batched_detail
+
+struct BatchKernels
+{
+    const char *name;
+    void (*factor)(double *a, int a_stride, int *piv, int n, int first, int last);
+    void (*solve)(const double *lu, int lu_stride, const int *piv, double *b, int b_stride, int n, int first, int last);
+};
+
+inline BatchKernels select_batch_kernels()
+{
+    using namespace batched_detail;
+#ifdef VECTOR_OPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return BatchKernels{"avx512", factor_avx512, solve_avx512};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return BatchKernels{"avx2", factor_avx2, solve_avx2};
+    }
+#endif
+    return BatchKernels{"scalar", factor_scalar, solve_scalar};
+}
+
+inline const BatchKernels &batch_kernels()
+{
+    static const BatchKernels kernels = select_batch_kernels();
+    return kernels;
+}
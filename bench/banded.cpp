@@ -0,0 +1,70 @@
+#include <iostream>
+#include <iomanip>
+
+#include "../second_task/iterative.cpp"
+
+// Ленточные и трёхдиагональные системы:
+//   - пятиточечный Лаплас на сетке k x k (лента kl = ku = k): плотное LU
+//     против ленточного (плотное - только до n_dense);
+//   - трёхдиагональная система длины n: прогонка против циклической
+//     редукции на 1 и threads потоках.
+// Запуск: ./banded [n_dense] [threads]
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    int nDense = argc > 1 ? atoi(argv[1]) : 2500;
+    int threads = argc > 2 ? atoi(argv[2]) : int(std::max(1u, std::thread::hardware_concurrency()));
+    ThreadPool pool(threads);
+
+    std::cout << "Laplace k x k, band kl = ku = k" << std::endl;
+    std::cout << "      n    band   dense LU, s   banded LU, s" << std::endl;
+    for (int k = 20; k <= 80; k *= 2)
+    {
+        int n = k * k;
+        Matrix A(n, n);
+        for (int i = 0; i < n; ++i)
+        {
+            A[i][i] = 4;
+            if (i % k > 0) A[i][i - 1] = -1;
+            if (i % k < k - 1) A[i][i + 1] = -1;
+            if (i >= k) A[i][i - k] = -1;
+            if (i + k < n) A[i][i + k] = -1;
+        }
+        std::cout << std::setw(7) << n << std::setw(8) << lower_bandwidth(A) << std::fixed << std::setprecision(4);
+        if (n <= nDense)
+        {
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            LUFactorization lu(A);
+            std::cout << std::setw(14) << seconds_since(begin);
+        }
+        else std::cout << std::setw(14) << "-";
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        BandFactorization band(A, k, k);
+        std::cout << std::setw(15) << seconds_since(begin) << std::defaultfloat << std::endl;
+    }
+
+    std::cout << "Tridiagonal, threads = " << threads << std::endl;
+    std::cout << "         n   Thomas, ms   CR, ms   CR pool, ms" << std::endl;
+    for (int n = 1 << 16; n <= (1 << 24); n *= 4)
+    {
+        Tridiagonal T;
+        T.a.assign(n, -1.0), T.b.assign(n, 2.5), T.c.assign(n, -1.0);
+        std::vector<double> d(n, 1.0);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        thomas_solve(T, d);
+        double thomas = seconds_since(begin);
+        begin = std::chrono::steady_clock::now();
+        cyclic_reduction_solve(T, d);
+        double serial = seconds_since(begin);
+        begin = std::chrono::steady_clock::now();
+        cyclic_reduction_solve(T, d, &pool);
+        double parallel = seconds_since(begin);
+        std::cout << std::setw(10) << n << std::fixed << std::setprecision(2) << std::setw(13) << thomas * 1e3
+                  << std::setw(9) << serial * 1e3 << std::setw(14) << parallel * 1e3 << std::defaultfloat << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "../second_task/iterative.cpp"
+
+// Решение count независимых систем n x n: по одной (LU_decomposition и
+// solve_system на каждую матрицу) и пакетом (MatrixBatch, системы группы
+// обрабатываются векторными операциями). Время на одну систему, мкс.
+// Запуск: ./batched_lu [count] [threads]
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 4096;
+    int threads = argc > 2 ? atoi(argv[2]) : int(std::max(1u, std::thread::hardware_concurrency()));
+    ThreadPool pool(threads);
+    srand(1);
+    std::cout << "count = " << count << ", threads = " << threads << ", kernels: " << batch_kernels().name << std::endl;
+    std::cout << "     n   single, us   batched, us   pool, us   max error" << std::endl;
+    for (int n : {5, 8, 12, 16, 24, 32, 48, 64})
+    {
+        std::vector<Matrix> A(count, Matrix(n, n));
+        std::vector<std::vector<double>> b(count, std::vector<double>(n));
+        MatrixBatch batch(n, count);
+        VectorBatch rhs(n, count);
+        for (int s = 0; s < count; ++s)
+        {
+            // Как matrix.csv: случайная матрица с диагональным преобладанием
+            for (int i = 0; i < n; ++i)
+            {
+                for (int j = 0; j < n; ++j) A[s][i][j] = double(rand()) * (RIGHT_BOUND - LEFT_BOUND) / RAND_MAX + LEFT_BOUND;
+                A[s][i][i] += n;
+                b[s][i] = double(rand()) / RAND_MAX;
+            }
+            batch.set(s, A[s]);
+            rhs.set(s, b[s]);
+        }
+
+        std::vector<std::vector<double>> x(count);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int s = 0; s < count; ++s)
+        {
+            Matrix LU = A[s];
+            std::vector<int> perm;
+            LU_decomposition(LU.view(), perm);
+            x[s] = solve_system(LU, perm, b[s]);
+        }
+        double single = seconds_since(begin);
+
+        MatrixBatch batchLU = batch;
+        VectorBatch solution = rhs;
+        std::vector<int> piv;
+        begin = std::chrono::steady_clock::now();
+        LU_decomposition(batchLU, piv);
+        solve_system(batchLU, piv, solution);
+        double batched = seconds_since(begin);
+
+        batchLU = batch;
+        VectorBatch poolSolution = rhs;
+        begin = std::chrono::steady_clock::now();
+        LU_decomposition(batchLU, piv, pool);
+        solve_system(batchLU, piv, poolSolution);
+        double pooled = seconds_since(begin);
+
+        double error = 0;
+        for (int s = 0; s < count; ++s)
+        {
+            for (int i = 0; i < n; ++i) error = std::max(error, std::abs(solution(s, i) - x[s][i]));
+        }
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(3) << std::setw(13) << single / count * 1e6
+                  << std::setw(14) << batched / count * 1e6 << std::setw(11) << pooled / count * 1e6
+                  << std::defaultfloat << std::setw(12) << error << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <string>
+
+#include "../second_task/iterative.cpp"
+
+// Собственные значения и векторы симметричной матрицы T методом вращений
+// Якоби - точный спектр для сравнения с оценками. T портится; столбцы V -
+// собственные векторы.
+void
+jacobi_eigen(Matrix &T, std::vector<double> &eigenvalues, Matrix &V)
+{
+    int m = T.rows();
+    V = Matrix(m, m);
+    for (int i = 0; i < m; ++i) V[i][i] = 1.0;
+    for (int sweep = 0; sweep < 100; ++sweep)
+    {
+        double off = 0.0, diag = 0.0;
+        for (int p = 0; p < m; ++p)
+        {
+            diag += T[p][p] * T[p][p];
+            for (int q = p + 1; q < m; ++q) off += T[p][q] * T[p][q];
+        }
+        if (off <= 1e-30 * diag) break;
+        for (int p = 0; p < m; ++p)
+        {
+            for (int q = p + 1; q < m; ++q)
+            {
+                if (T[p][q] == 0.0) continue;
+                double theta = (T[q][q] - T[p][p]) / (2.0 * T[p][q]);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (std::fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+                for (int k = 0; k < m; ++k)
+                {
+                    double tkp = T[k][p], tkq = T[k][q];
+                    T[k][p] = c * tkp - s * tkq;
+                    T[k][q] = s * tkp + c * tkq;
+                }
+                for (int k = 0; k < m; ++k)
+                {
+                    double tpk = T[p][k], tqk = T[q][k];
+                    T[p][k] = c * tpk - s * tqk;
+                    T[q][k] = s * tpk + c * tqk;
+                }
+                for (int k = 0; k < m; ++k)
+                {
+                    double vkp = V[k][p], vkq = V[k][q];
+                    V[k][p] = c * vkp - s * vkq;
+                    V[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    eigenvalues.resize(m);
+    for (int i = 0; i < m; ++i) eigenvalues[i] = T[i][i];
+}
+
+// Число итераций метода Чебышева с оценкой спектра по Гершгорину и
+// методом Ланцоша на матрицах SLAU_var_*.csv (как в second-task.cpp:
+// к диагонали прибавляется 1, итерации удваиваются, пока погрешность не
+// станет меньше погрешности LU-разложения). После файлов - одномерный
+// оператор Лапласа tridiag(-1, 2, -1): положительно определённая матрица
+// без диагонального преобладания с обусловленностью ~0.4 n^2, на которой
+// нижняя граница Гершгорина равна нулю. Для него LU-разложение точно до
+// уровня ошибок округления, поэтому итерации считаются до относительной
+// погрешности 1e-10.
+// Запуск из каталога bench: ./chebyshev_spectrum [файлы...]
+int iterations_to_lu_accuracy(const Matrix &A, const std::vector<double> &F, const std::vector<double> &x,
+                              double target, const std::vector<double> &spectrum)
+{
+    std::vector<float> statX, statY;
+    for (int maxIterations = 2; maxIterations <= (1 << 16); maxIterations *= 2)
+    {
+        std::vector<double> solution = chebyshevIteration(A, F, statX, statY, maxIterations, spectrum[0], spectrum[1]);
+        if (norm2(solution - x) < target) return maxIterations;
+    }
+    return -1;
+}
+
+// Оценки спектра и число итераций для матрицы A до погрешности LU или,
+// если relativeTarget > 0, до относительной погрешности relativeTarget
+void report(const std::string &name, const Matrix &A, double relativeTarget = 0.0)
+{
+    srand(1);
+    std::vector<double> x = generate_random_vect(A.rows());
+    std::vector<double> F = A * x;
+    LUFactorization lu(A);
+    double target = relativeTarget > 0 ? relativeTarget * norm2(x) : norm2(lu.solve(F) - x);
+
+    std::vector<double> gershgorin = eigenvalue_estimation(A);
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::vector<double> lanczos = lanczos_eigenvalue_estimation(A);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    std::cout << name << " (n = " << A.rows() << ")" << std::endl;
+    if (is_symmetric(A) && A.rows() <= 500)
+    {
+        Matrix T = A, V;
+        std::vector<double> exact;
+        jacobi_eigen(T, exact, V);
+        std::cout << "  точный спектр:   " << *std::min_element(exact.begin(), exact.end()) << " "
+                  << *std::max_element(exact.begin(), exact.end()) << std::endl;
+    }
+    std::cout << "  Гершгорин:       " << gershgorin << " итераций: "
+              << iterations_to_lu_accuracy(A, F, x, target, gershgorin) << std::endl;
+    std::cout << "  Ланцош:          " << lanczos << " итераций: "
+              << iterations_to_lu_accuracy(A, F, x, target, lanczos)
+              << " (оценка за " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()
+              << " мкс)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) files.push_back(argv[i]);
+    if (files.empty())
+    {
+        for (int k = 1; k <= 4; ++k) files.push_back("../SLAU_var_" + std::to_string(k) + ".csv");
+    }
+
+    for (const auto &filename : files)
+    {
+        Matrix A = read_csv(filename);
+        if (A.empty()) continue;
+        for (int i = 0; i < A.rows(); i++) ++A[i][i];
+        report(filename, A);
+    }
+
+    for (int n : {20, 50, 200})
+    {
+        Matrix A(n, n);
+        for (int i = 0; i < n; ++i)
+        {
+            A[i][i] = 2;
+            if (i > 0) A[i][i - 1] = -1;
+            if (i + 1 < n) A[i][i + 1] = -1;
+        }
+        report("tridiag(-1, 2, -1)", A, 1e-10);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "../second_task/iterative.cpp"
+
+// Умножение плотных матриц n x n, GFLOP/s (2 n^3 операций):
+//   naive   - прежний operator*: тройной цикл i-j-k (только до naive_max);
+//   gemm    - блочный gemm с упаковкой (текущий operator*);
+//   pool    - gemm на пуле из threads потоков.
+// Запуск: ./gemm [n_max] [threads] [naive_max]
+Matrix naive_multiply(const Matrix &m1, const Matrix &m2)
+{
+    Matrix res(m1.rows(), m2.cols());
+    for (int i = 0; i < m1.rows(); ++i)
+    {
+        for (int j = 0; j < m2.cols(); ++j)
+        {
+            double sum = 0.0;
+            for (int k = 0; k < m1.cols(); ++k) sum += m1[i][k] * m2[k][j];
+            res[i][j] = sum;
+        }
+    }
+    return res;
+}
+
+Matrix random_matrix(int n)
+{
+    Matrix A(n, n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j) A[i][j] = double(rand()) * (RIGHT_BOUND - LEFT_BOUND) / RAND_MAX + LEFT_BOUND;
+    }
+    return A;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Среднее время умножения: повторы, пока не наберётся 0.3 с
+template<typename Multiply>
+double time_multiply(Multiply multiply)
+{
+    int repeats = 1;
+    for (;;)
+    {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) multiply();
+        double time = seconds_since(begin);
+        if (time > 0.3) return time / repeats;
+        repeats *= 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int nMax = argc > 1 ? atoi(argv[1]) : 4096;
+    int threads = argc > 2 ? atoi(argv[2]) : int(std::max(1u, std::thread::hardware_concurrency()));
+    int naiveMax = argc > 3 ? atoi(argv[3]) : 1024;
+    srand(1);
+    ThreadPool pool(threads);
+    std::cout << "threads = " << threads << std::endl;
+    std::cout << "     n   naive, GFLOP/s   gemm, GFLOP/s   pool, GFLOP/s" << std::endl;
+    for (int n = 256; n <= nMax; n *= 2)
+    {
+        Matrix A = random_matrix(n), B = random_matrix(n);
+        double flops = 2.0 * n * n * n;
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(2);
+        if (n <= naiveMax) std::cout << std::setw(17) << flops / time_multiply([&] { naive_multiply(A, B); }) * 1e-9;
+        else std::cout << std::setw(17) << "-";
+        std::cout << std::setw(16) << flops / time_multiply([&] { A * B; }) * 1e-9;
+        std::cout << std::setw(16) << flops / time_multiply([&] { matrix_multiply(A, B, &pool); }) * 1e-9;
+        std::cout << std::defaultfloat << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+
+#include "../second_task/iterative.cpp"
+
+// Время до достижения точности для итерационных методов (Чебышев, CG,
+// BiCGSTAB) с разными предобусловливателями на матрицах SLAU_var_*.csv
+// (как в second-task.cpp, к диагонали прибавляется 1). Время включает
+// построение предобусловливателя и оценку спектра для метода Чебышева.
+// Для сравнения печатается время LU-разложения с решением.
+// Запуск из каталога bench: ./iterative_solvers [tolerance] [файлы...]
+typedef std::unique_ptr<Preconditioner> (*PreconditionerFactory)(const Matrix &A);
+
+std::unique_ptr<Preconditioner> no_preconditioner(const Matrix &) { return nullptr; }
+std::unique_ptr<Preconditioner> make_jacobi(const Matrix &A) { return std::unique_ptr<Preconditioner>(new JacobiPreconditioner(A)); }
+std::unique_ptr<Preconditioner> make_block_jacobi(const Matrix &A) { return std::unique_ptr<Preconditioner>(new BlockJacobiPreconditioner(A)); }
+std::unique_ptr<Preconditioner> make_ssor(const Matrix &A) { return std::unique_ptr<Preconditioner>(new SSORPreconditioner(A)); }
+std::unique_ptr<Preconditioner> make_ilu0(const Matrix &A) { return std::unique_ptr<Preconditioner>(new ILU0Preconditioner(A)); }
+
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    double tolerance = 1e-12;
+    std::vector<std::string> files;
+    if (argc > 1) tolerance = atof(argv[1]);
+    for (int i = 2; i < argc; ++i) files.push_back(argv[i]);
+    if (files.empty())
+    {
+        for (int k = 1; k <= 4; ++k) files.push_back("../SLAU_var_" + std::to_string(k) + ".csv");
+    }
+
+    const char *methodNames[] = {"Chebyshev", "CG", "BiCGSTAB"};
+    IterativeMethod methods[] = {chebyshev_solve, conjugate_gradient, bicgstab};
+    const char *preconditionerNames[] = {"none", "Jacobi", "block Jacobi", "SSOR", "ILU(0)"};
+    PreconditionerFactory factories[] = {no_preconditioner, make_jacobi, make_block_jacobi, make_ssor, make_ilu0};
+
+    for (const auto &filename : files)
+    {
+        Matrix A = read_csv(filename);
+        if (A.empty()) continue;
+        for (int i = 0; i < A.rows(); i++) ++A[i][i];
+        srand(1);
+        std::vector<double> x = generate_random_vect(A.rows());
+        std::vector<double> F = A * x;
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        LUFactorization lu(A);
+        std::vector<double> xLU = lu.solve(F);
+        double luTime = seconds_since(begin);
+
+        std::cout << filename << " (n = " << A.rows() << ", tolerance = " << tolerance
+                  << (is_symmetric(A) ? ", симметричная" : ", несимметричная") << ")" << std::endl;
+        std::cout << "  LU: " << luTime * 1e3 << " мс, погрешность " << norm2(xLU - x) << std::endl;
+        std::cout << "  method     preconditioner       iterations   ms     error" << std::endl;
+        for (int m = 0; m < 3; ++m)
+        {
+            for (int p = 0; p < 5; ++p)
+            {
+                std::cout << "  " << std::left << std::setw(11) << methodNames[m]
+                          << std::setw(21) << preconditionerNames[p] << std::right;
+                try
+                {
+                    begin = std::chrono::steady_clock::now();
+                    std::unique_ptr<Preconditioner> preconditioner = factories[p](A);
+                    IterativeOptions options;
+                    options.tolerance = tolerance;
+                    options.maxIterations = 100000;
+                    options.preconditioner = preconditioner.get();
+                    std::vector<double> solution(A.rows(), 0.0);
+                    IterativeResult result = methods[m](A, F, solution, options);
+                    double time = seconds_since(begin);
+                    std::cout << std::setw(8) << result.iterations << (result.converged ? " " : "*")
+                              << std::setw(10) << std::fixed << std::setprecision(2) << time * 1e3
+                              << std::defaultfloat << std::setprecision(6) << "  " << norm2(solution - x) << std::endl;
+                }
+                catch (const char *str)
+                {
+                    std::cout << "  " << str << std::endl;
+                }
+            }
+        }
+        std::cout << "  (* - точность не достигнута)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+#include "../lu.cpp"
+
+// Замер масштабируемости параллельного LU-разложения: одна и та же матрица
+// раскладывается на 1, 2, 4, ... N потоках.
+// Запуск: ./lu_scaling [n] [max_threads] [tile_size]
+int main(int argc, char **argv)
+{
+    int n = (argc > 1) ? std::atoi(argv[1]) : 2000;
+    int max_threads = (argc > 2) ? std::atoi(argv[2]) : int(std::max(1u, std::thread::hardware_concurrency()));
+    int tile = (argc > 3) ? std::atoi(argv[3]) : LU_TILE_SIZE;
+
+    srand(1);
+    Matrix A(n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) A[i][j] = double(rand()) * (RIGHT_BOUND - LEFT_BOUND) / RAND_MAX + LEFT_BOUND;
+    }
+    double flops = 2.0 / 3.0 * double(n) * n * n;
+
+    Matrix LU = A;
+    std::vector<int> perm;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    LU_factor_blocked(LU.view(), &perm);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double serial = std::chrono::duration<double>(end - begin).count();
+
+    std::cout << "n = " << n << ", плитка " << tile << std::endl;
+    std::cout << "последовательное блочное разложение: " << serial << " с, "
+              << flops / serial * 1e-9 << " GFLOP/s" << std::endl;
+    std::cout << "потоков  время, с    GFLOP/s  ускорение" << std::endl;
+
+    // 1, 2, 4, ... и сам max_threads
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+    thread_counts.push_back(max_threads);
+
+    double base = 0.0;
+    for (int threads : thread_counts) {
+        ThreadPool pool(threads);
+        LU = A;
+        begin = std::chrono::steady_clock::now();
+        LU_factor_parallel(LU.view(), &perm, pool, tile);
+        end = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double>(end - begin).count();
+        if (threads == 1) base = t;
+        std::cout << std::setw(7) << threads << std::setw(10) << std::setprecision(4) << t
+                  << std::setw(11) << flops / t * 1e-9 << std::setw(11) << base / t << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "../second_task/iterative.cpp"
+
+// Время одной итерации метода Чебышева x = x + tau * (F - A x):
+//   раздельно   - residual, затем axpy (два прохода по векторам);
+//   совмещённо  - chebyshev_update, один проход;
+//   ParallelMatrix на 1..max_threads потоках (строки закреплены за потоками).
+// Запуск: ./parallel_matvec [n] [max_threads]
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+template<typename Step>
+double time_per_iteration(Step step)
+{
+    int repeats = 1;
+    for (;;)
+    {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) step();
+        double time = seconds_since(begin);
+        if (time > 0.3) return time / repeats;
+        repeats *= 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 4000;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : int(std::max(1u, std::thread::hardware_concurrency()));
+    Matrix A(n, n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j) A[i][j] = 1.0 / (1 + std::abs(i - j));
+        A[i][i] += n;
+    }
+    std::vector<double> F(n, 1.0), x(n, 0.0), xNext(n), r(n), d(n, 0.0);
+    const double tau = 1.0 / n;
+    // Чтение матрицы за итерацию, байт
+    double bytes = double(n) * n * sizeof(double);
+
+    auto print = [bytes](const std::string &name, double time) {
+        std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << time * 1e3 << std::setw(10) << bytes / time * 1e-9 << std::defaultfloat << std::endl;
+    };
+    std::cout << "n = " << n << std::endl;
+    std::cout << "  variant                 time, ms   GB/s (A)" << std::endl;
+    print("separate", time_per_iteration([&] {
+        residual(A, x.data(), F.data(), r.data());
+        axpy(n, tau, r.data(), x.data());
+    }));
+    print("fused", time_per_iteration([&] {
+        chebyshev_update(A, x.data(), F.data(), 0.0, tau, r.data(), d.data(), xNext.data());
+        std::swap(x, xNext);
+    }));
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        ThreadPool pool(threads);
+        ParallelMatrix P(A, pool);
+        print("fused, " + std::to_string(threads) + " threads", time_per_iteration([&] {
+            chebyshev_update(P, x.data(), F.data(), 0.0, tau, r.data(), d.data(), xNext.data());
+            std::swap(x, xNext);
+        }));
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+    return 0;
+}
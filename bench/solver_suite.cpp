@@ -0,0 +1,367 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <cstdio>
+#include <ctime>
+
+#include "../second_task/iterative.cpp"
+
+// Набор замеров решателей в духе Google Benchmark: чтение матрицы (CSV и
+// двоичный формат), разложение DirectSolver, решение, solve_many и
+// итерационные методы на сгенерированных семействах матриц разных
+// размеров. Каждый замер повторяется, пока суммарное время не превысит
+// min_time; в таблицу и в JSON пишется время одного повторения, GFLOP/s,
+// пропускная способность по памяти и число итераций до точности.
+// Генераторы используют mt19937_64 с фиксированным зерном и собственное
+// преобразование в double, поэтому матрицы одинаковы на любой платформе.
+// Всё считается в одном потоке.
+// Запуск: ./solver_suite [n_max] [min_time] [фильтр] [файл.json]
+const double SUITE_TOLERANCE = 1e-10;
+const int SUITE_MAX_ITERATIONS = 1000;
+const int SUITE_RIGHT_HAND_SIDES = 32;
+const int SUITE_BANDWIDTH = 8;
+
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Равномерное число из [a, b)
+double uniform(std::mt19937_64 &rng, double a, double b)
+{
+    return a + (b - a) * double(rng() >> 11) * 0x1.0p-53;
+}
+
+// Как SLAU_var_*: симметричная, внедиагональные элементы из (-2, 2) с одним
+// знаком после запятой, диагональ - сумма модулей строки плюс 1 (как в second-task.cpp)
+Matrix generate_slau(int n, std::mt19937_64 &rng)
+{
+    Matrix A(n, n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < i; ++j) A[i][j] = A[j][i] = std::round(uniform(rng, -19.5, 19.5)) / 10;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        double sum = 0;
+        for (int j = 0; j < n; ++j) sum += j == i ? 0.0 : std::fabs(A[i][j]);
+        A[i][i] = sum + 1;
+    }
+    return A;
+}
+
+// Несимметричная со случайными элементами из [-1, 1) без преобладания
+Matrix generate_random(int n, std::mt19937_64 &rng)
+{
+    Matrix A(n, n);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < n; ++j) A[i][j] = uniform(rng, LEFT_BOUND, RIGHT_BOUND);
+    }
+    return A;
+}
+
+// Несимметричная ленточная с kl = ku = SUITE_BANDWIDTH и диагональным преобладанием
+Matrix generate_banded(int n, std::mt19937_64 &rng)
+{
+    Matrix A(n, n);
+    for (int i = 0; i < n; ++i)
+    {
+        int j0 = std::max(0, i - SUITE_BANDWIDTH), j1 = std::min(n - 1, i + SUITE_BANDWIDTH);
+        for (int j = j0; j <= j1; ++j) A[i][j] = uniform(rng, LEFT_BOUND, RIGHT_BOUND);
+        A[i][i] = 2 * SUITE_BANDWIDTH + 1;
+    }
+    return A;
+}
+
+// Симметричная положительно определённая без диагонального преобладания:
+// случайная симметричная с элементами из [-1, 1) (спектр примерно
+// в [-2 sqrt(n / 3), 2 sqrt(n / 3)]) со сдвигом диагонали 2.5 sqrt(n / 3)
+Matrix generate_spd(int n, std::mt19937_64 &rng)
+{
+    Matrix A(n, n);
+    double shift = 2.5 * std::sqrt(n / 3.0);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = 0; j <= i; ++j) A[i][j] = A[j][i] = uniform(rng, LEFT_BOUND, RIGHT_BOUND);
+        A[i][i] += shift;
+    }
+    return A;
+}
+
+struct MatrixFamily
+{
+    const char *name;
+    Matrix (*generate)(int n, std::mt19937_64 &rng);
+    // Итерационные методы сходятся (на random не запускаются)
+    bool iterative;
+    bool symmetric;
+};
+
+// Счётчики одного повторения, заполняются телом замера
+struct Counters
+{
+    double flops = 0;
+    double bytes = 0;
+    // Итерации метода до точности, -1 - не итерационный метод
+    int iterations = -1;
+    bool converged = true;
+    // Относительная погрешность решения по второй норме, -1 - не считалась
+    double error = -1;
+    std::string label;
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::string family;
+    int n;
+    long repeats;
+    double realTime, cpuTime;
+    Counters counters;
+};
+
+// Повторяет body, увеличивая число повторений, пока общее время не
+// превысит minTime (как Google Benchmark); первый короткий прогон служит прогревом
+BenchmarkResult run_benchmark(const std::string &name, const std::function<void(Counters &)> &body, double minTime)
+{
+    BenchmarkResult result;
+    result.name = name;
+    long repeats = 1;
+    for (;;)
+    {
+        Counters counters;
+        std::clock_t cpuBegin = std::clock();
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (long k = 0; k < repeats; ++k) body(counters);
+        double time = seconds_since(begin);
+        double cpuTime = double(std::clock() - cpuBegin) / CLOCKS_PER_SEC;
+        if (time >= minTime || repeats >= 1000000000L)
+        {
+            result.repeats = repeats;
+            result.realTime = time / repeats;
+            result.cpuTime = cpuTime / repeats;
+            result.counters = counters;
+            return result;
+        }
+        double factor = time > 0 ? std::min(10.0, std::max(2.0, 1.4 * minTime / time)) : 10.0;
+        repeats = long(repeats * factor);
+    }
+}
+
+double relative_error(const std::vector<double> &x, const std::vector<double> &xTrue)
+{
+    return norm2(x - xTrue) / norm2(xTrue);
+}
+
+// Арифметика и объём множителей для метода, выбранного DirectSolver
+double factor_flops(const DirectSolver &solver, int n, int kl, int ku)
+{
+    switch (solver.method())
+    {
+    case DirectSolver::TRIDIAGONAL: return 8.0 * n;
+    case DirectSolver::BANDED: return 2.0 * n * kl * (kl + ku + 1);
+    case DirectSolver::SYMMETRIC: return double(n) * n * n / 3;
+    default: return 2.0 * n * n * n / 3;
+    }
+}
+
+double solve_flops(const DirectSolver &solver, int n, int kl, int ku)
+{
+    switch (solver.method())
+    {
+    case DirectSolver::TRIDIAGONAL: return 8.0 * n;
+    case DirectSolver::BANDED: return 2.0 * n * (2 * kl + ku + 1);
+    default: return 2.0 * n * n;
+    }
+}
+
+double factor_bytes(const DirectSolver &solver, int n, int kl, int ku)
+{
+    switch (solver.method())
+    {
+    case DirectSolver::TRIDIAGONAL: return 3.0 * n * sizeof(double);
+    case DirectSolver::BANDED: return double(n) * (2 * kl + ku + 1) * sizeof(double);
+    case DirectSolver::SYMMETRIC: return double(n) * (n + 1) / 2 * sizeof(double);
+    default: return double(n) * n * sizeof(double);
+    }
+}
+
+void write_csv(const std::string &filename, const Matrix &A)
+{
+    std::FILE *file = std::fopen(filename.c_str(), "w");
+    if (!file) throw "Cannot write csv file";
+    for (int i = 0; i < A.rows(); ++i)
+    {
+        for (int j = 0; j < A.cols(); ++j) std::fprintf(file, j + 1 < A.cols() ? "%.17g," : "%.17g\n", A[i][j]);
+    }
+    std::fclose(file);
+}
+
+std::string json_string(const std::string &s)
+{
+    std::string ret = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\') ret += '\\';
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+// Формат близок к --benchmark_format=json из Google Benchmark: время в
+// наносекундах, пользовательские счётчики - поля самого замера
+void write_json(std::ostream &out, const std::vector<BenchmarkResult> &results, double minTime)
+{
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    out << std::setprecision(10) << "{\n  \"context\": {\n"
+        << "    \"date\": " << json_string(date) << ",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"vector_kernels\": " << json_string(vector_kernels().name) << ",\n"
+        << "    \"min_time\": " << minTime << ",\n"
+        << "    \"tolerance\": " << SUITE_TOLERANCE << "\n"
+        << "  },\n  \"benchmarks\": [";
+    for (std::size_t k = 0; k < results.size(); ++k)
+    {
+        const BenchmarkResult &r = results[k];
+        const Counters &c = r.counters;
+        out << (k ? "," : "") << "\n    {\"name\": " << json_string(r.name) << ", \"family\": " << json_string(r.family)
+            << ", \"n\": " << r.n << ", \"iterations\": " << r.repeats << ", \"real_time\": " << r.realTime * 1e9
+            << ", \"cpu_time\": " << r.cpuTime * 1e9 << ", \"time_unit\": \"ns\"";
+        if (c.flops > 0) out << ", \"gflops\": " << c.flops / r.realTime * 1e-9;
+        if (c.bytes > 0) out << ", \"bytes_per_second\": " << c.bytes / r.realTime;
+        if (c.iterations >= 0) out << ", \"solver_iterations\": " << c.iterations << ", \"converged\": " << (c.converged ? "true" : "false");
+        if (c.error >= 0) out << ", \"error\": " << c.error;
+        if (!c.label.empty()) out << ", \"label\": " << json_string(c.label);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    int nMax = argc > 1 ? atoi(argv[1]) : 1024;
+    double minTime = argc > 2 ? atof(argv[2]) : 0.2;
+    std::string filter = argc > 3 ? argv[3] : "";
+    std::string jsonFile = argc > 4 ? argv[4] : "solver_suite.json";
+    std::string csvFile = jsonFile + ".csv.tmp", binaryFile = jsonFile + ".bin.tmp";
+
+    MatrixFamily families[] = {
+        {"slau", generate_slau, true, true},
+        {"random", generate_random, false, false},
+        {"banded", generate_banded, true, false},
+        {"spd", generate_spd, true, true},
+    };
+    const char *methodNames[] = {"chebyshev", "cg", "bicgstab"};
+    IterativeMethod methods[] = {chebyshev_solve, conjugate_gradient, bicgstab};
+    // Умножений на матрицу за итерацию
+    const int matvecs[] = {1, 1, 2};
+
+    std::vector<BenchmarkResult> results;
+    std::cout << std::left << std::setw(34) << "benchmark" << std::right << std::setw(12) << "time, us"
+              << std::setw(10) << "GFLOP/s" << std::setw(9) << "GB/s" << std::setw(7) << "iters"
+              << std::setw(12) << "error" << "  label" << std::endl;
+    for (int n = 128; n <= nMax; n *= 2)
+    {
+        for (const MatrixFamily &family : families)
+        {
+            std::string suffix = std::string("/") + family.name + "/" + std::to_string(n);
+            std::mt19937_64 rng(n);
+            Matrix A = family.generate(n, rng);
+            std::vector<double> xTrue(n);
+            for (double &v : xTrue) v = uniform(rng, LEFT_BOUND, RIGHT_BOUND);
+            std::vector<double> F = A * xTrue;
+            int kl = lower_bandwidth(A), ku = upper_bandwidth(A);
+
+            std::vector<std::pair<std::string, std::function<void(Counters &)>>> benchmarks;
+            benchmarks.emplace_back("load_csv" + suffix, [&](Counters &c) {
+                Matrix B = read_csv(csvFile);
+                if (B.rows() != n) throw "Cannot read csv file";
+                c.bytes = double(std::ifstream(csvFile, std::ios::binary | std::ios::ate).tellg());
+            });
+            benchmarks.emplace_back("load_binary" + suffix, [&](Counters &c) {
+                Matrix B = read_matrix_binary<double>(binaryFile);
+                if (B.rows() != n) throw "Cannot read binary file";
+                c.bytes = double(n) * n * sizeof(double);
+            });
+            benchmarks.emplace_back("factor" + suffix, [&](Counters &c) {
+                DirectSolver solver(A);
+                c.flops = factor_flops(solver, n, kl, ku);
+                c.label = solver.method_name();
+            });
+            DirectSolver direct(A);
+            benchmarks.emplace_back("solve" + suffix, [&](Counters &c) {
+                std::vector<double> x = direct.solve(F);
+                c.flops = solve_flops(direct, n, kl, ku);
+                c.bytes = factor_bytes(direct, n, kl, ku);
+                c.error = relative_error(x, xTrue);
+                c.label = direct.method_name();
+            });
+            LUFactorization lu(A);
+            Matrix B(n, SUITE_RIGHT_HAND_SIDES);
+            for (int i = 0; i < n; ++i)
+            {
+                for (int j = 0; j < SUITE_RIGHT_HAND_SIDES; ++j) B[i][j] = F[i] * (j + 1);
+            }
+            benchmarks.emplace_back("solve_many" + suffix, [&](Counters &c) {
+                Matrix X = lu.solve_many(B);
+                c.flops = 2.0 * n * n * SUITE_RIGHT_HAND_SIDES;
+                c.bytes = double(n) * n * sizeof(double);
+                c.label = "LU, " + std::to_string(SUITE_RIGHT_HAND_SIDES) + " rhs";
+            });
+            for (int m = 0; m < 3 && family.iterative; ++m)
+            {
+                // CG и Чебышев рассчитаны на симметричные матрицы
+                if (m < 2 && !family.symmetric) continue;
+                benchmarks.emplace_back(methodNames[m] + suffix, [&, m](Counters &c) {
+                    IterativeOptions options;
+                    options.tolerance = SUITE_TOLERANCE;
+                    options.maxIterations = SUITE_MAX_ITERATIONS;
+                    std::vector<double> x(n, 0.0);
+                    IterativeResult result = methods[m](A, F, x, options);
+                    c.iterations = result.iterations;
+                    c.converged = result.converged;
+                    c.flops = 2.0 * n * n * matvecs[m] * result.iterations;
+                    c.bytes = double(n) * n * sizeof(double) * matvecs[m] * result.iterations;
+                    c.error = relative_error(x, xTrue);
+                });
+            }
+
+            bool filesWritten = false;
+            for (auto &benchmark : benchmarks)
+            {
+                if (benchmark.first.find(filter) == std::string::npos) continue;
+                if (benchmark.first.compare(0, 5, "load_") == 0 && !filesWritten)
+                {
+                    write_csv(csvFile, A);
+                    write_matrix_binary(binaryFile, A);
+                    filesWritten = true;
+                }
+                BenchmarkResult r = run_benchmark(benchmark.first, benchmark.second, minTime);
+                r.family = family.name;
+                r.n = n;
+                const Counters &c = r.counters;
+                std::cout << std::left << std::setw(34) << r.name << std::right << std::fixed << std::setprecision(1)
+                          << std::setw(12) << r.realTime * 1e6 << std::setprecision(2)
+                          << std::setw(10) << c.flops / r.realTime * 1e-9 << std::setw(9) << c.bytes / r.realTime * 1e-9
+                          << std::setw(7) << (c.iterations >= 0 ? std::to_string(c.iterations) + (c.converged ? "" : "*") : "-")
+                          << std::defaultfloat << std::setprecision(3) << std::setw(12);
+                if (c.error >= 0) std::cout << c.error;
+                else std::cout << "-";
+                std::cout << "  " << c.label << std::endl;
+                results.push_back(r);
+            }
+            std::remove(csvFile.c_str());
+            std::remove(binaryFile.c_str());
+        }
+    }
+
+    std::ofstream json(jsonFile);
+    write_json(json, results, minTime);
+    std::cout << "JSON: " << jsonFile << std::endl;
+    return 0;
+}
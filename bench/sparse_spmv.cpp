@@ -0,0 +1,121 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+
+#include "../second_task/iterative.cpp"
+
+// Умножение разреженной матрицы на вектор (SpMV) в форматах CSR и
+// SELL-C-sigma и метод сопряжённых градиентов на плотной и разреженной
+// матрице. Матрицы - пятиточечный оператор Лапласа на сетке k x k
+// (n = k^2, SPD) и та же матрица с добавленными случайными элементами
+// в части строк (строки разной длины, где сортировка SELL важна).
+// Запуск: ./sparse_spmv [k_max]
+CSRMatrix poisson_2d(int k, int extraRows = 0, int extraPerRow = 0)
+{
+    int n = k * k;
+    std::vector<int> I, J;
+    std::vector<double> V;
+    for (int y = 0; y < k; ++y)
+    {
+        for (int x = 0; x < k; ++x)
+        {
+            int i = y * k + x;
+            I.push_back(i), J.push_back(i), V.push_back(4.0 + extraPerRow);
+            if (x > 0) I.push_back(i), J.push_back(i - 1), V.push_back(-1.0);
+            if (x + 1 < k) I.push_back(i), J.push_back(i + 1), V.push_back(-1.0);
+            if (y > 0) I.push_back(i), J.push_back(i - k), V.push_back(-1.0);
+            if (y + 1 < k) I.push_back(i), J.push_back(i + k), V.push_back(-1.0);
+        }
+    }
+    std::mt19937 gen(1);
+    for (int r = 0; r < extraRows; ++r)
+    {
+        int i = int(gen() % n);
+        for (int e = 0; e < extraPerRow; ++e)
+        {
+            int j = int(gen() % n);
+            if (j == i) continue;
+            // Симметрично, с диагональным преобладанием
+            I.push_back(i), J.push_back(j), V.push_back(-0.5);
+            I.push_back(j), J.push_back(i), V.push_back(-0.5);
+            I.push_back(j), J.push_back(j), V.push_back(1.0);
+        }
+    }
+    return csr_from_triplets(n, n, I, J, V);
+}
+
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Среднее время одного умножения y = A x
+template<typename MatrixType, typename Multiply>
+double time_spmv(const MatrixType &A, Multiply multiply)
+{
+    std::vector<double> x(A.cols(), 1.0), y(A.rows());
+    int repeats = 1;
+    for (;;)
+    {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r) multiply(A, x.data(), y.data());
+        double time = seconds_since(begin);
+        if (time > 0.2) return time / repeats;
+        repeats *= 2;
+    }
+}
+
+void print_spmv(const char *name, double time, double nnz, double bytes)
+{
+    std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << time * 1e3 << std::setw(9) << 2 * nnz / time * 1e-9
+              << std::setw(9) << bytes / time * 1e-9 << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int kMax = argc > 1 ? atoi(argv[1]) : 1024;
+    std::cout << "Ядра SpMV: " << sparse_kernels().name << std::endl;
+    for (int k = 64; k <= kMax; k *= 4)
+    {
+        for (int irregular = 0; irregular < 2; ++irregular)
+        {
+            CSRMatrix A = irregular ? poisson_2d(k, k * k / 100, 64) : poisson_2d(k);
+            SellMatrix sell1(A, 1), sell(A);
+            double nnz = A.nnz();
+            // Обязательный трафик CSR: значения, индексы, row_ptr, x и y
+            double bytes = nnz * 12.0 + A.rows() * 4.0 + 2.0 * A.rows() * 8.0;
+            std::cout << "n = " << A.rows() << (irregular ? " (строки разной длины)" : " (Лаплас)")
+                      << ", nnz = " << A.nnz() << ", заполненность SELL-8-1: " << nnz / sell1.stored()
+                      << ", SELL-8-" << SELL_SIGMA << ": " << nnz / sell.stored() << std::endl;
+            std::cout << "  format           time, ms   GFLOP/s  GB/s" << std::endl;
+            print_spmv("CSR scalar", time_spmv(A, [](const CSRMatrix &M, const double *x, double *y) { gemv<double>(M, x, y); }), nnz, bytes);
+            print_spmv("CSR", time_spmv(A, [](const CSRMatrix &M, const double *x, double *y) { gemv(M, x, y); }), nnz, bytes);
+            print_spmv("SELL-8-1", time_spmv(sell1, [](const SellMatrix &M, const double *x, double *y) { gemv(M, x, y); }), nnz, bytes);
+            print_spmv("SELL-8-256", time_spmv(sell, [](const SellMatrix &M, const double *x, double *y) { gemv(M, x, y); }), nnz, bytes);
+        }
+    }
+
+    // CG на плотной и разреженной матрице: время итерации O(n^2) против O(nnz)
+    std::cout << "Метод сопряжённых градиентов, tolerance = 1e-10" << std::endl;
+    for (int k = 16; k <= 64; k *= 2)
+    {
+        CSRMatrix A = poisson_2d(k);
+        Matrix D = to_dense(A);
+        std::vector<double> F(A.rows(), 1.0);
+        IterativeOptions options;
+        options.maxIterations = 10000;
+
+        std::vector<double> xDense(A.rows(), 0.0), xSparse(A.rows(), 0.0);
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        IterativeResult dense = conjugate_gradient(D, F, xDense, options);
+        double denseTime = seconds_since(begin);
+        begin = std::chrono::steady_clock::now();
+        IterativeResult sparse = conjugate_gradient(A, F, xSparse, options);
+        double sparseTime = seconds_since(begin);
+        std::cout << "  n = " << A.rows() << ": итераций " << dense.iterations << " / " << sparse.iterations
+                  << ", плотная " << denseTime * 1e3 << " мс, CSR " << sparseTime * 1e3 << " мс" << std::endl;
+    }
+    return 0;
+}
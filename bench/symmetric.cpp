@@ -0,0 +1,61 @@
+#include <iostream>
+#include <iomanip>
+
+#include "../second_task/iterative.cpp"
+
+// Разложение симметричной матрицы с диагональным преобладанием (как
+// SLAU_var_*): LU с выбором по столбцу, Холецкий и LDL^T (Банч - Кауфман)
+// по нижнему треугольнику. Время разложения и память под множители.
+// Запуск: ./symmetric [n_max]
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int main(int argc, char **argv)
+{
+    int nMax = argc > 1 ? atoi(argv[1]) : 4000;
+    srand(1);
+    std::cout << "     n    LU, s   Cholesky, s   LDLT, s   LU, MB   half, MB   max residual" << std::endl;
+    for (int n = 500; n <= nMax; n *= 2)
+    {
+        Matrix A(n, n);
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < i; ++j) A[i][j] = A[j][i] = double(rand()) * (RIGHT_BOUND - LEFT_BOUND) / RAND_MAX + LEFT_BOUND;
+            A[i][i] = n;
+        }
+        std::vector<double> b(n, 1.0);
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        LUFactorization lu(A);
+        double luTime = seconds_since(begin);
+
+        begin = std::chrono::steady_clock::now();
+        SymmetricMatrix L(A);
+        bool spd = cholesky_factor(L);
+        double choleskyTime = seconds_since(begin);
+
+        begin = std::chrono::steady_clock::now();
+        SymmetricMatrix D(A);
+        std::vector<int> ipiv;
+        LDLT_factor(D, ipiv);
+        double ldltTime = seconds_since(begin);
+
+        std::vector<double> xLU = lu.solve(b), xC = b, xD = b;
+        cholesky_solve(L, xC.data());
+        LDLT_solve(D, ipiv, xD.data());
+        double residual = 0;
+        for (const std::vector<double> *x : {&xLU, &xC, &xD})
+        {
+            std::vector<double> r = A * *x;
+            for (int i = 0; i < n; ++i) residual = std::max(residual, std::abs(r[i] - b[i]));
+        }
+        double luMemory = double(lu.lu().rows()) * lu.lu().stride() * sizeof(double);
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(3) << std::setw(9) << luTime
+                  << std::setw(14) << choleskyTime << std::setw(10) << ldltTime << std::setprecision(1)
+                  << std::setw(9) << luMemory / 1048576 << std::setw(11) << L.memory() / 1048576.0
+                  << std::defaultfloat << std::setw(15) << residual << (spd ? "" : " (not SPD)") << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <iomanip>
+
+#include "../second_task/iterative.cpp"
+
+// Выражения над векторами: norm2(F - A * x) и x + tau * (F - y) с
+// промежуточными векторами (как раньше делали operator- / operator*) и
+// одним проходом через vector_expr.h. Время одного вычисления в мкс.
+// Запуск: ./vector_expr [n_max]
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Вычисление каждого узла в отдельный вектор
+std::vector<double> materialized_sub(const std::vector<double> &a, const std::vector<double> &b)
+{
+    std::vector<double> ret(a.size());
+    vector_sub(int(a.size()), a.data(), b.data(), ret.data());
+    return ret;
+}
+
+std::vector<double> materialized_product(const Matrix &A, const std::vector<double> &x)
+{
+    std::vector<double> ret(A.rows());
+    for (int i = 0; i < A.rows(); ++i) ret[i] = dot(A[i], x.data(), A.cols());
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    int nMax = argc > 1 ? atoi(argv[1]) : 4000;
+    srand(1);
+    std::cout << "     n   residual temp, us   residual fused, us   axpy temp, us   axpy fused, us" << std::endl;
+    for (int n = 250; n <= nMax; n *= 2)
+    {
+        Matrix A(n, n);
+        std::vector<double> x(n), y(n), F(n), z(n);
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j) A[i][j] = double(rand()) / RAND_MAX;
+            x[i] = double(rand()) / RAND_MAX, y[i] = double(rand()) / RAND_MAX, F[i] = double(rand()) / RAND_MAX;
+        }
+        int repeats = std::max(1, 20000000 / (n * n));
+        double tau = 0.5, sink = 0;
+
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        for (int k = 0; k < repeats; ++k) sink += norm2(materialized_sub(F, materialized_product(A, x)));
+        double residualTemp = seconds_since(begin) / repeats;
+
+        begin = std::chrono::steady_clock::now();
+        for (int k = 0; k < repeats; ++k) sink += norm2(F - A * x);
+        double residualFused = seconds_since(begin) / repeats;
+
+        int axpyRepeats = repeats * n;
+        begin = std::chrono::steady_clock::now();
+        for (int k = 0; k < axpyRepeats; ++k)
+        {
+            std::vector<double> d = materialized_sub(F, y);
+            std::vector<double> s(n);
+            for (int i = 0; i < n; ++i) s[i] = tau * d[i];
+            std::vector<double> t(n);
+            vector_add(n, x.data(), s.data(), t.data());
+            z = t;
+            sink += z[k % n];
+        }
+        double axpyTemp = seconds_since(begin) / axpyRepeats;
+
+        begin = std::chrono::steady_clock::now();
+        for (int k = 0; k < axpyRepeats; ++k)
+        {
+            evaluate(x + tau * (F - y), z);
+            sink += z[k % n];
+        }
+        double axpyFused = seconds_since(begin) / axpyRepeats;
+
+        std::cout << std::setw(6) << n << std::fixed << std::setprecision(3) << std::setw(20) << residualTemp * 1e6
+                  << std::setw(21) << residualFused * 1e6 << std::setw(16) << axpyTemp * 1e6
+                  << std::setw(17) << axpyFused * 1e6 << std::defaultfloat << (sink == 0 ? " " : "") << std::endl;
+    }
+    return 0;
+}
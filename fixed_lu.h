@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// LU-разложение матриц фиксированного размера N x N, известного при
+// компиляции. Матрица лежит в std::array (без динамической памяти), у
+// циклов постоянные границы, и компилятор разворачивает их целиком.
+// Все функции constexpr: разложение можно посчитать при компиляции.
+// Интерфейс тот же, что у LU_decomposition и solve_system в lu.cpp.
+
+template<std::size_t N>
+using FixedMatrix = std::array<std::array<double, N>, N>;
+
+template<std::size_t N>
+using FixedVector = std::array<double, N>;
+
+template<std::size_t N>
+using FixedPermutation = std::array<int, N>;
+
+namespace fixed_lu_detail
+{
+
+// std::abs и std::swap не constexpr в C++17
+constexpr double abs(double x)
+{
+    return x < 0 ? -x : x;
+}
+
+template<typename T>
+constexpr void swap(T &a, T &b)
+{
+    T t = a;
+    a = b;
+    b = t;
+}
+
+} // namespace fixed_lu_detail
+
+// Упакованное LU-разложение на месте без выбора ведущего элемента
+template<std::size_t N>
+constexpr void LU_decomposition(FixedMatrix<N> &A)
+{
+#pragma GCC unroll 16
+    for (std::size_t k = 0; k < N; k++) {
+        if (A[k][k] == 0) throw "Matrix is singular";
+#pragma GCC unroll 16
+        for (std::size_t i = k + 1; i < N; i++) {
+            double lik = A[i][k] / A[k][k];
+            A[i][k] = lik;
+#pragma GCC unroll 16
+            for (std::size_t j = k + 1; j < N; j++) A[i][j] -= lik * A[k][j];
+        }
+    }
+}
+
+// Упакованное LU-разложение на месте с выбором ведущего элемента по
+// столбцу: PA = LU, строка i матрицы PA - строка perm[i] исходной
+template<std::size_t N>
+constexpr void LU_decomposition(FixedMatrix<N> &A, FixedPermutation<N> &perm)
+{
+    for (std::size_t i = 0; i < N; i++) perm[i] = int(i);
+#pragma GCC unroll 16
+    for (std::size_t k = 0; k < N; k++) {
+        std::size_t p = k;
+        for (std::size_t i = k + 1; i < N; i++) {
+            if (fixed_lu_detail::abs(A[i][k]) > fixed_lu_detail::abs(A[p][k])) p = i;
+        }
+        if (A[p][k] == 0) throw "Matrix is singular";
+        if (p != k) {
+            fixed_lu_detail::swap(A[p], A[k]);
+            fixed_lu_detail::swap(perm[p], perm[k]);
+        }
+#pragma GCC unroll 16
+        for (std::size_t i = k + 1; i < N; i++) {
+            double lik = A[i][k] / A[k][k];
+            A[i][k] = lik;
+#pragma GCC unroll 16
+            for (std::size_t j = k + 1; j < N; j++) A[i][j] -= lik * A[k][j];
+        }
+    }
+}
+
+// Решение L U x = b по упакованному разложению
+template<std::size_t N>
+constexpr FixedVector<N> solve_system(const FixedMatrix<N> &LU, const FixedVector<N> &b)
+{
+    FixedVector<N> x = b;
+#pragma GCC unroll 16
+    for (std::size_t i = 0; i < N; i++) {
+        for (std::size_t j = 0; j < i; j++) x[i] -= LU[i][j] * x[j];
+    }
+#pragma GCC unroll 16
+    for (std::size_t r = 0; r < N; r++) {
+        std::size_t i = N - 1 - r;
+        for (std::size_t j = i + 1; j < N; j++) x[i] -= LU[i][j] * x[j];
+        x[i] /= LU[i][i];
+    }
+    return x;
+}
+
+// Решение PA x = b: правая часть переставляется по perm
+template<std::size_t N>
+constexpr FixedVector<N> solve_system(const FixedMatrix<N> &LU, const FixedPermutation<N> &perm, const FixedVector<N> &b)
+{
+    FixedVector<N> pb{};
+    for (std::size_t i = 0; i < N; i++) pb[i] = b[perm[i]];
+    return solve_system(LU, pb);
+}
+
+// Разложение копии A, удобно для вычисления при компиляции:
+//   constexpr auto LU = LU_factorized(A);
+template<std::size_t N>
+constexpr FixedMatrix<N> LU_factorized(FixedMatrix<N> A, FixedPermutation<N> &perm)
+{
+    LU_decomposition(A, perm);
+    return A;
+}
+
+template<std::size_t N>
+constexpr FixedMatrix<N> LU_factorized(FixedMatrix<N> A)
+{
+    LU_decomposition(A);
+    return A;
+}
+
+// Проверка при компиляции: система с перестановкой строк и точным решением (1, 2, 3)
+namespace fixed_lu_detail
+{
+
+constexpr FixedMatrix<3> check_matrix = {{{0, 2, 1}, {4, 1, 0}, {2, 0, 3}}};
+
+constexpr FixedVector<3> check_solve()
+{
+    FixedMatrix<3> A = check_matrix;
+    FixedPermutation<3> perm{};
+    LU_decomposition(A, perm);
+    return solve_system(A, perm, FixedVector<3>{7, 6, 11});
+}
+
+static_assert(check_solve()[0] == 1 && check_solve()[1] == 2 && check_solve()[2] == 3,
+              "Fixed-size LU gives a wrong solution");
+
+} // namespace fixed_lu_detail
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "matrix.h"
+#include "thread_pool.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KERNELS_X86 1
+#endif
+
+// Параметры блочного умножения матриц. MR x NR - блок C, который микроядро
+// держит в регистрах; KC x NR - полоска упакованной B (должна лежать в L1);
+// MC x KC - упакованный блок A (в L2); KC x NC - упакованная панель B (в L3).
+const int GEMM_MR = 4;
+const int GEMM_NR = 8;
+const int GEMM_MC = 96;
+const int GEMM_KC = 256;
+const int GEMM_NC = 2048;
+
+// Микроядро: C[mr x nr] += alpha * Apack(MR x kc) * Bpack(kc x NR).
+// Аккумуляторы имеют фиксированный размер MR x NR, поэтому компилятор
+// раскладывает их по регистрам и векторизует цикл по j.
+template<typename T>
+inline void gemm_micro_kernel(int kc, T alpha, const T *a, const T *b, T *c, int ldc, int mr, int nr)
+{
+    T acc[GEMM_MR][GEMM_NR] = {};
+    for (int p = 0; p < kc; ++p) {
+        const T *bp = b + p * GEMM_NR;
+        const T *ap = a + p * GEMM_MR;
+        for (int i = 0; i < GEMM_MR; ++i) {
+            T ai = ap[i];
+            for (int j = 0; j < GEMM_NR; ++j) {
+                acc[i][j] += ai * bp[j];
+            }
+        }
+    }
+    for (int i = 0; i < mr; ++i) {
+        T *ci = c + std::ptrdiff_t(i) * ldc;
+        for (int j = 0; j < nr; ++j) {
+            ci[j] += alpha * acc[i][j];
+        }
+    }
+}
+
+namespace gemm_detail
+{
+
+// Прибавление блока acc (MR x NR) к неполному краевому блоку C
+inline void add_partial_tile(double alpha, const double (&acc)[GEMM_MR][GEMM_NR], double *c, int ldc, int mr, int nr)
+{
+    for (int i = 0; i < mr; ++i) {
+        for (int j = 0; j < nr; ++j) c[std::ptrdiff_t(i) * ldc + j] += alpha * acc[i][j];
+    }
+}
+
+#ifdef KERNELS_X86
+
+// 4 x 8 на AVX2: 8 аккумуляторов ymm, на шаг p - две загрузки B,
+// четыре broadcast из A и восемь FMA
+__attribute__((target("avx2,fma"))) inline void micro_kernel_avx2(int kc, double alpha, const double *a, const double *b,
+                                                                  double *c, int ldc, int mr, int nr)
+{
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd(), c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    for (int p = 0; p < kc; ++p) {
+        __m256d b0 = _mm256_loadu_pd(b + p * GEMM_NR), b1 = _mm256_loadu_pd(b + p * GEMM_NR + 4);
+        const double *ap = a + p * GEMM_MR;
+        __m256d a0 = _mm256_broadcast_sd(ap), a1 = _mm256_broadcast_sd(ap + 1);
+        c00 = _mm256_fmadd_pd(a0, b0, c00), c01 = _mm256_fmadd_pd(a0, b1, c01);
+        c10 = _mm256_fmadd_pd(a1, b0, c10), c11 = _mm256_fmadd_pd(a1, b1, c11);
+        __m256d a2 = _mm256_broadcast_sd(ap + 2), a3 = _mm256_broadcast_sd(ap + 3);
+        c20 = _mm256_fmadd_pd(a2, b0, c20), c21 = _mm256_fmadd_pd(a2, b1, c21);
+        c30 = _mm256_fmadd_pd(a3, b0, c30), c31 = _mm256_fmadd_pd(a3, b1, c31);
+    }
+    __m256d acc[GEMM_MR][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}};
+    if (mr == GEMM_MR && nr == GEMM_NR) {
+        __m256d al = _mm256_set1_pd(alpha);
+        for (int i = 0; i < GEMM_MR; ++i) {
+            double *ci = c + std::ptrdiff_t(i) * ldc;
+            _mm256_storeu_pd(ci, _mm256_fmadd_pd(al, acc[i][0], _mm256_loadu_pd(ci)));
+            _mm256_storeu_pd(ci + 4, _mm256_fmadd_pd(al, acc[i][1], _mm256_loadu_pd(ci + 4)));
+        }
+        return;
+    }
+    double tile[GEMM_MR][GEMM_NR];
+    for (int i = 0; i < GEMM_MR; ++i) _mm256_storeu_pd(tile[i], acc[i][0]), _mm256_storeu_pd(tile[i] + 4, acc[i][1]);
+    add_partial_tile(alpha, tile, c, ldc, mr, nr);
+}
+
+// 4 x 8 на AVX-512: строка блока C - один регистр zmm. Четырёх
+// аккумуляторов мало, чтобы скрыть задержку FMA, поэтому чётные и
+// нечётные шаги p накапливаются в разных регистрах (всего 8)
+__attribute__((target("avx512f"))) inline void micro_kernel_avx512(int kc, double alpha, const double *a, const double *b,
+                                                                   double *c, int ldc, int mr, int nr)
+{
+    __m512d e0 = _mm512_setzero_pd(), e1 = _mm512_setzero_pd(), e2 = _mm512_setzero_pd(), e3 = _mm512_setzero_pd();
+    __m512d o0 = _mm512_setzero_pd(), o1 = _mm512_setzero_pd(), o2 = _mm512_setzero_pd(), o3 = _mm512_setzero_pd();
+    int p = 0;
+    for (; p + 2 <= kc; p += 2) {
+        const double *ap = a + p * GEMM_MR;
+        __m512d be = _mm512_loadu_pd(b + p * GEMM_NR), bo = _mm512_loadu_pd(b + (p + 1) * GEMM_NR);
+        e0 = _mm512_fmadd_pd(_mm512_set1_pd(ap[0]), be, e0);
+        e1 = _mm512_fmadd_pd(_mm512_set1_pd(ap[1]), be, e1);
+        e2 = _mm512_fmadd_pd(_mm512_set1_pd(ap[2]), be, e2);
+        e3 = _mm512_fmadd_pd(_mm512_set1_pd(ap[3]), be, e3);
+        o0 = _mm512_fmadd_pd(_mm512_set1_pd(ap[4]), bo, o0);
+        o1 = _mm512_fmadd_pd(_mm512_set1_pd(ap[5]), bo, o1);
+        o2 = _mm512_fmadd_pd(_mm512_set1_pd(ap[6]), bo, o2);
+        o3 = _mm512_fmadd_pd(_mm512_set1_pd(ap[7]), bo, o3);
+    }
+    if (p < kc) {
+        const double *ap = a + p * GEMM_MR;
+        __m512d be = _mm512_loadu_pd(b + p * GEMM_NR);
+        e0 = _mm512_fmadd_pd(_mm512_set1_pd(ap[0]), be, e0);
+        e1 = _mm512_fmadd_pd(_mm512_set1_pd(ap[1]), be, e1);
+        e2 = _mm512_fmadd_pd(_mm512_set1_pd(ap[2]), be, e2);
+        e3 = _mm512_fmadd_pd(_mm512_set1_pd(ap[3]), be, e3);
+    }
+    __m512d acc[GEMM_MR] = {_mm512_add_pd(e0, o0), _mm512_add_pd(e1, o1), _mm512_add_pd(e2, o2), _mm512_add_pd(e3, o3)};
+    if (mr == GEMM_MR && nr == GEMM_NR) {
+        __m512d al = _mm512_set1_pd(alpha);
+        for (int i = 0; i < GEMM_MR; ++i) {
+            double *ci = c + std::ptrdiff_t(i) * ldc;
+            _mm512_storeu_pd(ci, _mm512_fmadd_pd(al, acc[i], _mm512_loadu_pd(ci)));
+        }
+        return;
+    }
+    double tile[GEMM_MR][GEMM_NR];
+    for (int i = 0; i < GEMM_MR; ++i) _mm512_storeu_pd(tile[i], acc[i]);
+    add_partial_tile(alpha, tile, c, ldc, mr, nr);
+}
+
+#endif
+
+typedef void (*MicroKernel)(int kc, double alpha, const double *a, const double *b, double *c, int ldc, int mr, int nr);
+
+inline MicroKernel select_micro_kernel()
+{
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return micro_kernel_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return micro_kernel_avx2;
+#endif
+    return gemm_micro_kernel<double>;
+}
+
+} // namespace gemm_detail
+
+// Микроядро для double: вариант на AVX2/AVX-512 выбирается один раз по
+// возможностям процессора (как в vector_ops.h)
+inline void gemm_micro_kernel(int kc, double alpha, const double *a, const double *b, double *c, int ldc, int mr, int nr)
+{
+    static const gemm_detail::MicroKernel kernel = gemm_detail::select_micro_kernel();
+    kernel(kc, alpha, a, b, c, ldc, mr, nr);
+}
+
+// Упаковка блока A (mc x kc) в полоски по MR строк: [полоска][p][i].
+// Неполная последняя полоска дополняется нулями.
+template<typename T>
+void gemm_pack_a(BasicMatrixView<const T> A, T *buf)
+{
+    int mc = A.rows(), kc = A.cols();
+    for (int i0 = 0; i0 < mc; i0 += GEMM_MR) {
+        int mr = std::min(GEMM_MR, mc - i0);
+        for (int p = 0; p < kc; ++p) {
+            for (int i = 0; i < mr; ++i) buf[i] = A(i0 + i, p);
+            for (int i = mr; i < GEMM_MR; ++i) buf[i] = T();
+            buf += GEMM_MR;
+        }
+    }
+}
+
+// Упаковка панели B (kc x nc) в полоски по NR столбцов: [полоска][p][j]
+template<typename T>
+void gemm_pack_b(BasicMatrixView<const T> B, T *buf)
+{
+    int kc = B.rows(), nc = B.cols();
+    for (int j0 = 0; j0 < nc; j0 += GEMM_NR) {
+        int nr = std::min(GEMM_NR, nc - j0);
+        for (int p = 0; p < kc; ++p) {
+            const T *bp = B[p] + j0;
+            for (int j = 0; j < nr; ++j) buf[j] = bp[j];
+            for (int j = nr; j < GEMM_NR; ++j) buf[j] = T();
+            buf += GEMM_NR;
+        }
+    }
+}
+
+// Макроядро: C[mc x nc] += alpha * Apack * Bpack для упакованных блоков
+template<typename T>
+void gemm_macro_kernel(int mc, int nc, int kc, T alpha, const T *a_pack, const T *b_pack, BasicMatrixView<T> C)
+{
+    for (int jr = 0; jr < nc; jr += GEMM_NR) {
+        int nr = std::min(GEMM_NR, nc - jr);
+        const T *bp = b_pack + std::ptrdiff_t(jr / GEMM_NR) * kc * GEMM_NR;
+        for (int ir = 0; ir < mc; ir += GEMM_MR) {
+            int mr = std::min(GEMM_MR, mc - ir);
+            const T *ap = a_pack + std::ptrdiff_t(ir / GEMM_MR) * kc * GEMM_MR;
+            gemm_micro_kernel(kc, alpha, ap, bp, &C(ir, jr), C.stride(), mr, nr);
+        }
+    }
+}
+
+// C += alpha * A * B (A: m x k, B: k x n, C: m x n).
+// Блочный алгоритм с упаковкой: панель B и блок A копируются в непрерывные
+// буферы, после чего микроядро читает их строго последовательно.
+template<typename T>
+void gemm(T alpha, BasicMatrixView<const T> A, BasicMatrixView<const T> B, BasicMatrixView<T> C)
+{
+    if (A.cols() != B.rows() || A.rows() != C.rows() || B.cols() != C.cols()) throw "Matrix sizes doesnt match";
+    int m = C.rows(), n = C.cols(), k = A.cols();
+    if (m == 0 || n == 0 || k == 0) return;
+
+    // Буферы своих у каждого потока, чтобы gemm можно было вызывать параллельно
+    thread_local std::vector<T> a_buf, b_buf;
+    a_buf.resize(std::size_t(GEMM_MC + GEMM_MR) * GEMM_KC);
+    b_buf.resize(std::size_t(GEMM_NC + GEMM_NR) * GEMM_KC);
+
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = std::min(GEMM_NC, n - jc);
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = std::min(GEMM_KC, k - pc);
+            gemm_pack_b(B.block(pc, jc, kc, nc), b_buf.data());
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = std::min(GEMM_MC, m - ic);
+                gemm_pack_a(A.block(ic, pc, mc, kc), a_buf.data());
+                gemm_macro_kernel(mc, nc, kc, alpha, a_buf.data(), b_buf.data(), C.block(ic, jc, mc, nc));
+            }
+        }
+    }
+}
+
+// Многопоточный вариант: панель B упаковывается один раз вызывающим
+// потоком, а блоки C (MC строк на полосу из NR-кратного числа столбцов)
+// раздаются задачами пула; каждая задача упаковывает свой блок A в
+// буфер своего потока. Полос по столбцам столько, чтобы задач было
+// хотя бы вчетверо больше, чем потоков. Результат совпадает с
+// последовательным gemm бит в бит. Нельзя вызывать из задачи того же пула.
+template<typename T>
+void gemm(T alpha, BasicMatrixView<const T> A, BasicMatrixView<const T> B, BasicMatrixView<T> C, ThreadPool &pool)
+{
+    if (A.cols() != B.rows() || A.rows() != C.rows() || B.cols() != C.cols()) throw "Matrix sizes doesnt match";
+    int m = C.rows(), n = C.cols(), k = A.cols();
+    if (m == 0 || n == 0 || k == 0) return;
+    if (pool.size() == 1) {
+        gemm(alpha, A, B, C);
+        return;
+    }
+
+    std::vector<T> b_buf(std::size_t(GEMM_NC + GEMM_NR) * GEMM_KC);
+    int row_blocks = (m + GEMM_MC - 1) / GEMM_MC;
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = std::min(GEMM_NC, n - jc);
+        int col_blocks = std::max(1, std::min((nc + 127) / 128, (4 * pool.size() + row_blocks - 1) / row_blocks));
+        int col_width = ((nc + col_blocks - 1) / col_blocks + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+        for (int pc = 0; pc < k; pc += GEMM_KC) {
+            int kc = std::min(GEMM_KC, k - pc);
+            gemm_pack_b(B.block(pc, jc, kc, nc), b_buf.data());
+            const T *b_pack = b_buf.data();
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                for (int jr = 0; jr < nc; jr += col_width) {
+                    pool.submit([=] {
+                        thread_local std::vector<T> a_buf;
+                        a_buf.resize(std::size_t(GEMM_MC + GEMM_MR) * GEMM_KC);
+                        int mc = std::min(GEMM_MC, m - ic), width = std::min(col_width, nc - jr);
+                        gemm_pack_a(A.block(ic, pc, mc, kc), a_buf.data());
+                        gemm_macro_kernel(mc, width, kc, alpha, a_buf.data(), b_pack + std::ptrdiff_t(jr / GEMM_NR) * kc * GEMM_NR,
+                                          C.block(ic, jc + jr, mc, width));
+                    });
+                }
+            }
+            // Следующая панель B пакуется в тот же буфер
+            pool.wait();
+        }
+    }
+}
+
+// B = L^{-1} * B, где L - нижняя треугольная матрица с единичной диагональю
+// (диагональ и верхний треугольник L не читаются)
+template<typename T>
+void trsm_lower_unit(BasicMatrixView<const T> L, BasicMatrixView<T> B)
+{
+    int n = B.rows(), m = B.cols();
+    for (int i = 0; i < n; ++i) {
+        T *Bi = B[i];
+        const T *Li = L[i];
+        for (int p = 0; p < i; ++p) {
+            T lip = Li[p];
+            if (lip == T()) continue;
+            const T *Bp = B[p];
+            for (int j = 0; j < m; ++j) Bi[j] -= lip * Bp[j];
+        }
+    }
+}
+
+// B = U^{-1} * B, где U - верхняя треугольная матрица
+// (нижний треугольник U не читается)
+template<typename T>
+void trsm_upper(BasicMatrixView<const T> U, BasicMatrixView<T> B)
+{
+    int n = B.rows(), m = B.cols();
+    for (int i = n - 1; i >= 0; --i) {
+        T *Bi = B[i];
+        const T *Ui = U[i];
+        for (int p = i + 1; p < n; ++p) {
+            T uip = Ui[p];
+            if (uip == T()) continue;
+            const T *Bp = B[p];
+            for (int j = 0; j < m; ++j) Bi[j] -= uip * Bp[j];
+        }
+        T inv = T(1) / Ui[i];
+        for (int j = 0; j < m; ++j) Bi[j] *= inv;
+    }
+}
@@ -1,10 +1,31 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
-#include <sstream>
 #include <string>
 #include <cmath>
 #include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <charconv>
+#include <cctype>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+
+#include "matrix.h"
+#include "kernels.h"
+#include "thread_pool.h"
+#include "vector_ops.h"
+#include "mapped_file.h"
+#include "matrix_file.h"
+#include "sparse_matrix.h"
+#include "parallel_matvec.h"
+#include "batched_lu.h"
+#include "fixed_lu.h"
+#include "symmetric.h"
+#include "banded.h"
+#include "vector_expr.h"
+#include "profiler.h"
 
 enum
 {
@@ -12,104 +33,1156 @@ enum
     RIGHT_BOUND = 1
 };
 
-// Функция для выполнения LU-разложения
-void LU_decomposition(std::vector<std::vector<double>>& A, std::vector<std::vector<double>>& L, std::vector<std::vector<double>>& U)
+// Ширина панели блочного LU-разложения. Панель nb столбцов и блок nb x nb
+// должны помещаться в L1/L2; подбирается под конкретный процессор.
+const int LU_BLOCK_SIZE = 64;
+
+// Стратегия выбора ведущего элемента
+enum Pivoting
 {
-    int n = A.size();
-    L.resize(n, std::vector<double>(n, 0));
-    U.resize(n, std::vector<double>(n, 0));
-    for (int i = 0; i < n; i++) {
-        L[i][i] = 1;
+    NO_PIVOTING,
+    PARTIAL_PIVOTING,  // по столбцу: PA = LU
+    COMPLETE_PIVOTING  // по всей подматрице: PAQ = LU
+};
+
+// Неблочное LU-разложение панели A (m x nb, m >= nb) на месте:
+// под диагональю остаются множители L, на диагонали и выше - U.
+// Если piv != nullptr, выбирается ведущий элемент по столбцу; строки
+// переставляются только внутри панели, а номер выбранной строки j-го шага
+// записывается в piv[j] (как ipiv в LAPACK), чтобы остальные столбцы
+// можно было переставить потом одним проходом.
+template<typename T>
+void LU_factor_panel(BasicMatrixView<T> A, int *piv = nullptr)
+{
+    int m = A.rows(), nb = A.cols();
+    for (int j = 0; j < nb; j++) {
+        if (piv) {
+            int p = j;
+            T max = std::abs(A[j][j]);
+            for (int i = j + 1; i < m; i++) {
+                if (std::abs(A[i][j]) > max) max = std::abs(A[i][j]), p = i;
+            }
+            if (max == T()) throw "Matrix is singular";
+            piv[j] = p;
+            if (p != j) std::swap_ranges(A[j], A[j] + nb, A[p]);
+        }
+        const T *Aj = A[j];
+        for (int i = j + 1; i < m; i++) {
+            T *Ai = A[i];
+            T lij = Ai[j] / Aj[j];
+            Ai[j] = lij;
+            for (int c = j + 1; c < nb; c++) {
+                Ai[c] -= lij * Aj[c];
+            }
+        }
+    }
+}
+
+// Блочное правостороннее LU-разложение на месте. На шаге k раскладывается
+// панель A[k:n, k:k+nb], затем строится строка U12 = L11^{-1} A12 и
+// обновляется оставшаяся подматрица A22 -= L21 * U12 ядром gemm.
+// Результат упакован в A: L (единичная диагональ не хранится) и U.
+// Если perm != nullptr, используется выбор ведущего элемента по столбцу
+// и в perm возвращается перестановка: строка i матрицы PA - это строка
+// perm[i] исходной матрицы. Перестановки панели применяются к остальным
+// столбцам отложенно, одним проходом на панель.
+template<typename T>
+void LU_factor_blocked(BasicMatrixView<T> A, std::vector<int> *perm, int block_size = LU_BLOCK_SIZE)
+{
+    if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+    if (block_size < 1) throw "Block size should be positive";
+    int n = A.rows();
+    PROFILE_SCOPE("LU_decomposition");
+    PROFILE_FLOPS(2.0 / 3.0 * n * n * n);
+    std::vector<int> piv(perm ? block_size : 0);
+    if (perm) {
+        perm->resize(n);
+        for (int i = 0; i < n; i++) (*perm)[i] = i;
+    }
+    for (int k = 0; k < n; k += block_size) {
+        int kb = std::min(block_size, n - k);
+        LU_factor_panel(A.block(k, k, n - k, kb), perm ? piv.data() : nullptr);
+        int rest = n - k - kb;
+        if (perm) {
+            for (int j = 0; j < kb; j++) {
+                int p = piv[j];
+                if (p == j) continue;
+                std::swap((*perm)[k + j], (*perm)[k + p]);
+                std::swap_ranges(A[k + j], A[k + j] + k, A[k + p]);
+                std::swap_ranges(A[k + j] + k + kb, A[k + j] + n, A[k + p] + k + kb);
+            }
+        }
+        if (rest == 0) break;
+        BasicMatrixView<T> A12 = A.block(k, k + kb, kb, rest);
+        trsm_lower_unit<T>(A.block(k, k, kb, kb), A12);
+        gemm<T>(T(-1), A.block(k + kb, k, rest, kb), A12, A.block(k + kb, k + kb, rest, rest));
+    }
+}
+
+template<typename T>
+void LU_factor_blocked(BasicMatrixView<T> A, int block_size = LU_BLOCK_SIZE)
+{
+    LU_factor_blocked(A, nullptr, block_size);
+}
+
+// Размер квадратной плитки (tile) параллельного LU-разложения
+const int LU_TILE_SIZE = 128;
+
+// Параллельное блочное LU-разложение на месте (результат как у
+// LU_factor_blocked). Матрица делится на плитки nb x nb, шаг k состоит из
+// задач трёх видов:
+//   P(k)    - разложение панели (блочного столбца k) с выбором ведущего
+//             элемента;
+//   U(k, j) - перестановка строк панели k в блочном столбце j и решение
+//             треугольной системы для плитки (k, j);
+//   G(k, i, j) - обновление плитки A(i, j) -= L(i, k) * U(k, j).
+// Задачи запускаются по мере готовности зависимостей, а не по барьеру в
+// конце шага, поэтому панель k+1 раскладывается, как только обновлён
+// столбец k+1, одновременно с остальными обновлениями шага k.
+// Перестановки строк в уже готовых столбцах L применяются в конце.
+template<typename T>
+void LU_factor_parallel(BasicMatrixView<T> A, std::vector<int> *perm, ThreadPool &pool, int block_size = LU_TILE_SIZE)
+{
+    if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+    if (block_size < 1) throw "Block size should be positive";
+    int n = A.rows();
+    PROFILE_SCOPE("LU_decomposition");
+    PROFILE_FLOPS(2.0 / 3.0 * n * n * n);
+    int nb = block_size;
+    int nt = (n + nb - 1) / nb;
+    auto offset = [&](int t) { return t * nb; };
+    auto width = [&](int t) { return std::min(nb, n - t * nb); };
+
+    // ipiv[r] - глобальный номер строки, с которой меняется строка r
+    std::vector<int> ipiv(n);
+    // Счётчики невыполненных зависимостей: P(k) и U(k, j)
+    std::vector<std::atomic<int>> wait_panel(nt);
+    std::vector<std::atomic<int>> wait_update(std::size_t(nt) * nt);
+    for (int k = 0; k < nt; k++) {
+        wait_panel[k] = (k == 0) ? 0 : nt - k;
+        for (int j = k + 1; j < nt; j++) wait_update[std::size_t(k) * nt + j] = 1 + ((k == 0) ? 0 : nt - k);
+    }
+
+    std::function<void(int)> run_panel;
+    std::function<void(int, int)> run_update;
+    std::function<void(int, int, int)> run_tile;
+
+    // Завершение зависимости U(k, j) или P(k) (при j == k)
+    auto release = [&](int k, int j) {
+        if (j == k) {
+            if (--wait_panel[k] == 0) pool.submit([&run_panel, k] { run_panel(k); });
+        } else if (--wait_update[std::size_t(k) * nt + j] == 0) {
+            pool.submit([&run_update, k, j] { run_update(k, j); });
+        }
+    };
+
+    run_panel = [&](int k) {
+        int k0 = offset(k), kb = width(k);
+        std::vector<int> piv(kb);
+        LU_factor_panel(A.block(k0, k0, n - k0, kb), perm ? piv.data() : nullptr);
+        for (int j = 0; j < kb; j++) ipiv[k0 + j] = perm ? k0 + piv[j] : k0 + j;
+        // Последние запускаются первыми: ближний к панели столбец раньше
+        for (int j = nt - 1; j > k; j--) release(k, j);
+    };
+
+    run_update = [&](int k, int j) {
+        int k0 = offset(k), kb = width(k);
+        int j0 = offset(j), jb = width(j);
+        for (int r = k0; r < k0 + kb; r++) {
+            if (ipiv[r] != r) std::swap_ranges(A[r] + j0, A[r] + j0 + jb, A[ipiv[r]] + j0);
+        }
+        trsm_lower_unit<T>(A.block(k0, k0, kb, kb), A.block(k0, j0, kb, jb));
+        for (int i = nt - 1; i > k; i--) pool.submit([&run_tile, k, i, j] { run_tile(k, i, j); });
+    };
+
+    run_tile = [&](int k, int i, int j) {
+        int k0 = offset(k), kb = width(k);
+        int i0 = offset(i), ib = width(i);
+        int j0 = offset(j), jb = width(j);
+        gemm<T>(T(-1), A.block(i0, k0, ib, kb), A.block(k0, j0, kb, jb), A.block(i0, j0, ib, jb));
+        release(k + 1, j);
+    };
+
+    pool.submit([&run_panel] { run_panel(0); });
+    pool.wait();
+
+    // Отложенные перестановки строк в столбцах слева от каждой панели
+    for (int k = 1; k < nt; k++) {
+        int k0 = offset(k), kb = width(k);
+        for (int r = k0; r < k0 + kb; r++) {
+            if (ipiv[r] != r) std::swap_ranges(A[r], A[r] + k0, A[ipiv[r]]);
+        }
+    }
+    if (perm) {
+        perm->resize(n);
+        for (int i = 0; i < n; i++) (*perm)[i] = i;
+        for (int r = 0; r < n; r++) std::swap((*perm)[r], (*perm)[ipiv[r]]);
     }
+}
+
+// LU-разложение с выбором ведущего элемента по всей оставшейся подматрице:
+// PAQ = LU. Поиск максимума на каждом шаге просматривает всю подматрицу,
+// поэтому разложение не блочное; нужно для плохо обусловленных матриц,
+// где выбора по столбцу недостаточно.
+template<typename T>
+void LU_factor_complete(BasicMatrixView<T> A, std::vector<int> &row_perm, std::vector<int> &col_perm)
+{
+    if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+    int n = A.rows();
+    PROFILE_SCOPE("LU_decomposition");
+    PROFILE_FLOPS(2.0 / 3.0 * n * n * n);
+    row_perm.resize(n), col_perm.resize(n);
+    for (int i = 0; i < n; i++) row_perm[i] = col_perm[i] = i;
     for (int k = 0; k < n; k++) {
-        U[k][k] = A[k][k];   
-        for (int i = k + 1; i < n; i++) {
-            L[i][k] = A[i][k] / U[k][k];
-            U[k][i] = A[k][i];
+        int p = k, q = k;
+        T max = T();
+        for (int i = k; i < n; i++) {
+            const T *Ai = A[i];
+            for (int j = k; j < n; j++) {
+                if (std::abs(Ai[j]) > max) max = std::abs(Ai[j]), p = i, q = j;
+            }
+        }
+        if (max == T()) throw "Matrix is singular";
+        if (p != k) {
+            std::swap_ranges(A[k], A[k] + n, A[p]);
+            std::swap(row_perm[k], row_perm[p]);
         }
+        if (q != k) {
+            for (int i = 0; i < n; i++) std::swap(A[i][k], A[i][q]);
+            std::swap(col_perm[k], col_perm[q]);
+        }
+        const T *Ak = A[k];
         for (int i = k + 1; i < n; i++) {
+            T *Ai = A[i];
+            T lik = Ai[k] / Ak[k];
+            Ai[k] = lik;
             for (int j = k + 1; j < n; j++) {
-                A[i][j] = A[i][j] - L[i][k] * U[k][j];
+                Ai[j] -= lik * Ak[j];
             }
         }
     }
 }
 
-// Функция для решения системы линейных уравнений
-std::vector<double> solve_system(std::vector<std::vector<double>>& L, std::vector<std::vector<double>>& U, std::vector<double>& b)
+// Распаковка упакованного разложения A в отдельные L и U
+void LU_unpack(ConstMatrixView A, Matrix& L, Matrix& U)
 {
-    int n = L.size();
-    std::vector<double> y(n, 0);
+    int n = A.rows();
+    L = Matrix(n, n);
+    U = Matrix(n, n);
     for (int i = 0; i < n; i++) {
-        double sum = 0;
+        const double *Ai = A[i];
+        double *Li = L[i];
+        double *Ui = U[i];
+        std::copy(Ai, Ai + i, Li);
+        Li[i] = 1;
+        std::copy(Ai + i, Ai + n, Ui + i);
+    }
+}
+
+// LU-разложение на месте: A перезаписывается упакованными L и U
+// (как в LAPACK getrf), дополнительная память под матрицы не выделяется.
+// Для решения системы упакованная матрица передаётся в solve_system.
+void LU_decomposition(MatrixView A)
+{
+    LU_factor_blocked(A);
+}
+
+// Упакованное LU-разложение на месте с выбором ведущего элемента по столбцу
+void LU_decomposition(MatrixView A, std::vector<int>& perm)
+{
+    LU_factor_blocked(A, &perm);
+}
+
+// Параллельное упакованное LU-разложение на месте (PA = LU) на пуле потоков
+void LU_decomposition(MatrixView A, std::vector<int>& perm, ThreadPool& pool)
+{
+    LU_factor_parallel(A, &perm, pool);
+}
+
+// Упакованное LU-разложение на месте с выбором ведущего элемента по всей матрице
+void LU_decomposition(MatrixView A, std::vector<int>& row_perm, std::vector<int>& col_perm)
+{
+    LU_factor_complete(A, row_perm, col_perm);
+}
+
+// Функция для выполнения LU-разложения. L и U возвращаются отдельными
+// матрицами, A при этом перезаписывается упакованным разложением
+void LU_decomposition(MatrixView A, Matrix& L, Matrix& U)
+{
+    LU_factor_blocked(A);
+    LU_unpack(A, L, U);
+}
+
+// LU-разложение с выбором ведущего элемента по столбцу: PA = LU
+void LU_decomposition(MatrixView A, Matrix& L, Matrix& U, std::vector<int>& perm)
+{
+    LU_factor_blocked(A, &perm);
+    LU_unpack(A, L, U);
+}
+
+// LU-разложение с выбором ведущего элемента по всей матрице: PAQ = LU
+void LU_decomposition(MatrixView A, Matrix& L, Matrix& U, std::vector<int>& row_perm, std::vector<int>& col_perm)
+{
+    LU_factor_complete(A, row_perm, col_perm);
+    LU_unpack(A, L, U);
+}
+
+// Прямая и обратная подстановки на месте: x = U^{-1} L^{-1} x.
+// Из L читается только строго нижний треугольник (диагональ считается
+// единичной), из U - диагональ и верхний треугольник, поэтому для
+// упакованного разложения в L и U передаётся одна и та же матрица.
+// Своего этапа профилирования нет: подстановки вызываются и из
+// предобусловливателей, и из уточнения, поэтому операции учитываются
+// в этапе вызывающего (solve_system, LUFactorization::solve и т.д.).
+template<typename T>
+void LU_substitute(BasicMatrixView<const T> L, BasicMatrixView<const T> U, T *x)
+{
+    int n = L.rows();
+    PROFILE_FLOPS(2.0 * n * n);
+    PROFILE_BYTES(double(n) * n * sizeof(T));
+    for (int i = 0; i < n; i++) {
+        const T *Li = L[i];
+        T sum = 0;
         for (int j = 0; j < i; j++) {
-            sum += L[i][j] * y[j];
+            sum += Li[j] * x[j];
         }
-        y[i] = b[i] - sum;
+        x[i] -= sum;
     }
-    std::vector<double> x(n, 0);
     for (int i = n - 1; i >= 0; i--) {
-        double sum = 0;
+        const T *Ui = U[i];
+        T sum = 0;
         for (int j = i + 1; j < n; j++) {
-            sum += U[i][j] * x[j];
+            sum += Ui[j] * x[j];
         }
-        x[i] = (y[i] - sum) / U[i][i];
+        x[i] = (x[i] - sum) / Ui[i];
     }
+}
+
+// Правая часть P b: элемент i берётся из строки perm[i]
+std::vector<double> permute(const std::vector<int>& perm, const std::vector<double>& b)
+{
+    std::vector<double> pb(perm.size());
+    for (int i = 0; i < int(perm.size()); i++) pb[i] = b[perm[i]];
+    return pb;
+}
+
+// Обратная перестановка компонент решения: x[col_perm[i]] = z[i]
+std::vector<double> unpermute(const std::vector<int>& col_perm, const std::vector<double>& z)
+{
+    std::vector<double> x(z.size());
+    for (int i = 0; i < int(z.size()); i++) x[col_perm[i]] = z[i];
+    return x;
+}
+
+// Функция для решения системы линейных уравнений
+std::vector<double> solve_system(ConstMatrixView L, ConstMatrixView U, const std::vector<double>& b)
+{
+    PROFILE_SCOPE("solve_system");
+    std::vector<double> x = b;
+    LU_substitute(L, U, x.data());
     return x;
 }
 
+// Решение системы PA x = L U x = P b: правая часть переставляется по perm
+std::vector<double> solve_system(ConstMatrixView L, ConstMatrixView U, const std::vector<int>& perm, const std::vector<double>& b)
+{
+    PROFILE_SCOPE("solve_system");
+    std::vector<double> x = permute(perm, b);
+    LU_substitute(L, U, x.data());
+    return x;
+}
+
+// Решение системы PAQ (Q^T x) = P b: после подстановок компоненты
+// решения возвращаются на свои места по col_perm
+std::vector<double> solve_system(ConstMatrixView L, ConstMatrixView U, const std::vector<int>& row_perm, const std::vector<int>& col_perm, const std::vector<double>& b)
+{
+    return unpermute(col_perm, solve_system(L, U, row_perm, b));
+}
+
+// Решение системы по упакованному разложению LU без перестановок
+std::vector<double> solve_system(ConstMatrixView LU, const std::vector<double>& b)
+{
+    return solve_system(LU, LU, b);
+}
+
+// Решение системы по упакованному разложению PA = LU
+std::vector<double> solve_system(ConstMatrixView LU, const std::vector<int>& perm, const std::vector<double>& b)
+{
+    return solve_system(LU, LU, perm, b);
+}
+
+// Решение системы по упакованному разложению PAQ = LU
+std::vector<double> solve_system(ConstMatrixView LU, const std::vector<int>& row_perm, const std::vector<int>& col_perm, const std::vector<double>& b)
+{
+    return solve_system(LU, LU, row_perm, col_perm, b);
+}
+
+// Блочные подстановки на месте для нескольких правых частей сразу:
+// X = U^{-1} L^{-1} X, столбцы X - отдельные правые части. Диагональные
+// блоки решаются trsm, а вклад решённого блока в остальные строки
+// вычитается ядром gemm, так что каждый блок L и U читается один раз на
+// весь набор правых частей, а не по разу на вектор.
+template<typename T>
+void LU_substitute_many(BasicMatrixView<const T> L, BasicMatrixView<const T> U, BasicMatrixView<T> X, int block_size = LU_BLOCK_SIZE)
+{
+    if (L.rows() != X.rows()) throw "Matrix sizes doesnt match";
+    int n = X.rows(), m = X.cols();
+    PROFILE_FLOPS(2.0 * n * n * m);
+    PROFILE_BYTES(double(n) * n * sizeof(T));
+    for (int i0 = 0; i0 < n; i0 += block_size) {
+        int ib = std::min(block_size, n - i0);
+        BasicMatrixView<T> Xi = X.block(i0, 0, ib, m);
+        trsm_lower_unit<T>(L.block(i0, i0, ib, ib), Xi);
+        int rest = n - i0 - ib;
+        if (rest > 0) gemm<T>(T(-1), L.block(i0 + ib, i0, rest, ib), Xi, X.block(i0 + ib, 0, rest, m));
+    }
+    int last = (n - 1) / block_size * block_size;
+    for (int i0 = last; i0 >= 0; i0 -= block_size) {
+        int ib = std::min(block_size, n - i0);
+        BasicMatrixView<T> Xi = X.block(i0, 0, ib, m);
+        trsm_upper<T>(U.block(i0, i0, ib, ib), Xi);
+        if (i0 > 0) gemm<T>(T(-1), U.block(0, i0, i0, ib), Xi, X.block(0, 0, i0, m));
+    }
+}
+
+// Решение системы с матрицей правых частей B (n x k): A X = L U X = B
+Matrix solve_many(ConstMatrixView L, ConstMatrixView U, ConstMatrixView B)
+{
+    PROFILE_SCOPE("solve_many");
+    Matrix X(B.rows(), B.cols());
+    for (int i = 0; i < B.rows(); i++) std::copy(B[i], B[i] + B.cols(), X[i]);
+    if (!X.empty()) LU_substitute_many(L, U, X.view());
+    return X;
+}
+
+// Решение PA X = B: строки B переставляются по perm
+Matrix solve_many(ConstMatrixView L, ConstMatrixView U, const std::vector<int>& perm, ConstMatrixView B)
+{
+    PROFILE_SCOPE("solve_many");
+    Matrix X(B.rows(), B.cols());
+    for (int i = 0; i < B.rows(); i++) std::copy(B[perm[i]], B[perm[i]] + B.cols(), X[i]);
+    if (!X.empty()) LU_substitute_many(L, U, X.view());
+    return X;
+}
+
+// Решение PAQ X = B: строки решения возвращаются на места по col_perm
+Matrix solve_many(ConstMatrixView L, ConstMatrixView U, const std::vector<int>& row_perm, const std::vector<int>& col_perm, ConstMatrixView B)
+{
+    Matrix Z = solve_many(L, U, row_perm, B);
+    Matrix X(Z.rows(), Z.cols());
+    for (int i = 0; i < Z.rows(); i++) std::copy(Z[i], Z[i] + Z.cols(), X[col_perm[i]]);
+    return X;
+}
+
+// Варианты для упакованного разложения
+Matrix solve_many(ConstMatrixView LU, ConstMatrixView B)
+{
+    return solve_many(LU, LU, B);
+}
+
+Matrix solve_many(ConstMatrixView LU, const std::vector<int>& perm, ConstMatrixView B)
+{
+    return solve_many(LU, LU, perm, B);
+}
+
+Matrix solve_many(ConstMatrixView LU, const std::vector<int>& row_perm, const std::vector<int>& col_perm, ConstMatrixView B)
+{
+    return solve_many(LU, LU, row_perm, col_perm, B);
+}
+
+// Пакетное LU-разложение на месте множества маленьких систем (см.
+// batched_lu.h) с выбором ведущего элемента по столбцу в каждой системе.
+// piv - перестановки всех систем, n * BATCH_LANES чисел на группу; вместе
+// с упакованными матрицами передаётся в solve_system.
+void LU_decomposition(MatrixBatch& A, std::vector<int>& piv)
+{
+    piv.resize(std::size_t(A.groups()) * A.size() * BATCH_LANES);
+    if (A.groups() > 0) batch_kernels().factor(A.group(0), A.stride(), piv.data(), A.size(), 0, A.groups());
+}
+
+// То же на пуле потоков: группы делятся на непрерывные части
+void LU_decomposition(MatrixBatch& A, std::vector<int>& piv, ThreadPool& pool)
+{
+    piv.resize(std::size_t(A.groups()) * A.size() * BATCH_LANES);
+    int chunk = std::max(1, A.groups() / (4 * pool.size()));
+    for (int first = 0; first < A.groups(); first += chunk) {
+        int last = std::min(A.groups(), first + chunk);
+        double *a = A.group(0);
+        int *p = piv.data();
+        int stride = A.stride(), n = A.size();
+        pool.submit([=] { batch_kernels().factor(a, stride, p, n, first, last); });
+    }
+    pool.wait();
+}
+
+// Решение пакета систем по пакетному разложению; b перезаписывается решениями
+void solve_system(const MatrixBatch& LU, const std::vector<int>& piv, VectorBatch& b)
+{
+    if (LU.size() != b.size() || LU.count() != b.count()) throw "Matrix and vector sizes doesnt match";
+    if (LU.groups() == 0) return;
+    batch_kernels().solve(LU.group(0), LU.stride(), piv.data(), b.group(0), b.stride(), LU.size(), 0, LU.groups());
+}
+
+// Число шагов итерационного уточнения по умолчанию
+const int LU_REFINE_ITERATIONS = 5;
+
+const char LU_FILE_MAGIC[8] = {'C', 'H', 'M', 'Y', 'L', 'U', '\0', '\0'};
+const std::uint32_t LU_FILE_VERSION = 1;
+
+// Заголовок файла сохранённого разложения. За ним идут row_perm и
+// col_perm (по n чисел int32), выравнивание до MATRIX_ALIGNMENT и сама
+// упакованная матрица LU в формате matrix_file.h.
+struct LUFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t pivoting;
+    std::uint64_t n;
+    std::uint64_t matrix_offset;
+    std::uint8_t reserved[32];
+};
+static_assert(sizeof(LUFileHeader) == MATRIX_ALIGNMENT, "LU file header should be 64 bytes");
+
+// Готовое LU-разложение для многократного решения систем с одной матрицей.
+// Хранит упакованные L и U, перестановки и рабочие векторы; разложение
+// можно сохранить на диск и загрузить в другом запуске, не повторяя O(n^3).
+// Перестановки хранятся всегда (тождественные, если не использовались).
+// Методы решения используют общий рабочий буфер, поэтому один объект
+// нельзя использовать из нескольких потоков одновременно.
+class LUFactorization
+{
+public:
+    LUFactorization() : pivoting_(PARTIAL_PIVOTING) {}
+
+    explicit LUFactorization(ConstMatrixView A, Pivoting pivoting = PARTIAL_PIVOTING, ThreadPool* pool = nullptr)
+    {
+        factor(A, pivoting, pool);
+    }
+
+    // Разложение копии A. Пул используется для выбора по столбцу.
+    void factor(ConstMatrixView A, Pivoting pivoting = PARTIAL_PIVOTING, ThreadPool* pool = nullptr)
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        int n = A.rows();
+        pivoting_ = pivoting;
+        lu_ = Matrix(n, n);
+        for (int i = 0; i < n; i++) std::copy(A[i], A[i] + n, lu_[i]);
+        row_perm_.resize(n), col_perm_.resize(n);
+        for (int i = 0; i < n; i++) row_perm_[i] = col_perm_[i] = i;
+        switch (pivoting) {
+        case NO_PIVOTING:
+            LU_factor_blocked(lu_.view());
+            break;
+        case PARTIAL_PIVOTING:
+            if (pool) LU_factor_parallel(lu_.view(), &row_perm_, *pool);
+            else LU_factor_blocked(lu_.view(), &row_perm_);
+            break;
+        case COMPLETE_PIVOTING:
+            LU_factor_complete(lu_.view(), row_perm_, col_perm_);
+            break;
+        }
+        work_.resize(n);
+    }
+
+    int size() const { return lu_.rows(); }
+    bool empty() const { return lu_.empty(); }
+    Pivoting pivoting() const { return pivoting_; }
+    const Matrix& lu() const { return lu_; }
+    const std::vector<int>& row_perm() const { return row_perm_; }
+    const std::vector<int>& col_perm() const { return col_perm_; }
+
+    // Решение A x = b в буфер вызывающего (x может совпадать с b)
+    void solve(const std::vector<double>& b, std::vector<double>& x) const
+    {
+        PROFILE_SCOPE("LUFactorization::solve");
+        int n = size();
+        if (int(b.size()) != n) throw "Matrix and vector sizes doesnt match";
+        for (int i = 0; i < n; i++) work_[i] = b[row_perm_[i]];
+        LU_substitute<double>(lu_, lu_, work_.data());
+        x.resize(n);
+        for (int i = 0; i < n; i++) x[col_perm_[i]] = work_[i];
+    }
+
+    std::vector<double> solve(const std::vector<double>& b) const
+    {
+        std::vector<double> x;
+        solve(b, x);
+        return x;
+    }
+
+    // Решение A X = B для матрицы правых частей
+    Matrix solve_many(ConstMatrixView B) const
+    {
+        PROFILE_SCOPE("LUFactorization::solve_many");
+        if (B.rows() != size()) throw "Matrix sizes doesnt match";
+        return ::solve_many(lu_, lu_, row_perm_, col_perm_, B);
+    }
+
+    // Итерационное уточнение решения x системы A x = b (A - исходная
+    // матрица, по которой строилось разложение): r = b - A x, A d = r,
+    // x += d. Останавливается, когда max|r| <= tolerance или после
+    // max_iterations поправок. Возвращает max|r| последней невязки.
+    double refine(ConstMatrixView A, const std::vector<double>& b, std::vector<double>& x,
+                  int max_iterations = LU_REFINE_ITERATIONS, double tolerance = 0.0) const
+    {
+        int n = size();
+        if (A.rows() != n || int(b.size()) != n || int(x.size()) != n) throw "Matrix and vector sizes doesnt match";
+        std::vector<double> r(n);
+        double norm = 0.0;
+        for (int it = 0; ; it++) {
+            residual(A, x.data(), b.data(), r.data());
+            norm = max_abs(r.data(), n);
+            if (it == max_iterations || norm <= tolerance) break;
+            solve(r, r);
+            axpy(n, 1.0, r.data(), x.data());
+        }
+        return norm;
+    }
+
+    // Сохранение разложения в файл. Возвращает false при ошибке записи.
+    bool save(const std::string& filename) const
+    {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error when try to open file" << std::endl;
+            return false;
+        }
+        std::uint64_t n = size();
+        std::uint64_t perms_end = sizeof(LUFileHeader) + 2 * n * sizeof(std::int32_t);
+        LUFileHeader header = {};
+        std::memcpy(header.magic, LU_FILE_MAGIC, sizeof(header.magic));
+        header.version = LU_FILE_VERSION;
+        header.pivoting = pivoting_;
+        header.n = n;
+        header.matrix_offset = (perms_end + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        std::vector<std::int32_t> perm(row_perm_.begin(), row_perm_.end());
+        file.write(reinterpret_cast<const char *>(perm.data()), std::streamsize(n * sizeof(std::int32_t)));
+        perm.assign(col_perm_.begin(), col_perm_.end());
+        file.write(reinterpret_cast<const char *>(perm.data()), std::streamsize(n * sizeof(std::int32_t)));
+        std::vector<char> padding(header.matrix_offset - perms_end, 0);
+        file.write(padding.data(), std::streamsize(padding.size()));
+        return write_matrix_binary<double>(file, lu_.view());
+    }
+
+    // Загрузка разложения, сохранённого save. Возвращает false (с
+    // сообщением в cerr), если файл не открылся или повреждён.
+    bool load(const std::string& filename, bool verify_checksum = true)
+    {
+        MappedFile file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Error when try to open file" << std::endl;
+            return false;
+        }
+        LUFileHeader header;
+        const char *error = nullptr;
+        ConstMatrixView lu;
+        if (file.size() < sizeof(header)) {
+            error = "File is too small for LU header";
+        } else {
+            std::memcpy(&header, file.data(), sizeof(header));
+            if (std::memcmp(header.magic, LU_FILE_MAGIC, sizeof(header.magic)) != 0) error = "Not an LU factorization file";
+            else if (header.version != LU_FILE_VERSION) error = "Unsupported LU file version";
+            else if (header.pivoting > COMPLETE_PIVOTING) error = "Corrupted LU header";
+            else if (header.n > std::uint64_t(std::numeric_limits<int>::max())) error = "Corrupted LU header";
+            else if (header.matrix_offset % MATRIX_ALIGNMENT != 0 || header.matrix_offset > file.size() ||
+                     header.matrix_offset < sizeof(header) + 2 * header.n * sizeof(std::int32_t)) error = "Corrupted LU header";
+            else error = parse_matrix_binary(file.data() + header.matrix_offset, file.size() - header.matrix_offset, verify_checksum, lu);
+            if (!error && (std::uint64_t(lu.rows()) != header.n || lu.cols() != lu.rows())) error = "Corrupted LU header";
+        }
+        int n = error ? 0 : int(header.n);
+        // Контрольная сумма покрывает только матрицу, поэтому перестановки
+        // проверяются отдельно: иначе solve выйдет за границы массивов
+        std::vector<std::int32_t> row_perm(n), col_perm(n);
+        if (!error) {
+            const char *perms = file.data() + sizeof(header);
+            std::memcpy(row_perm.data(), perms, n * sizeof(std::int32_t));
+            std::memcpy(col_perm.data(), perms + n * sizeof(std::int32_t), n * sizeof(std::int32_t));
+            if (!is_permutation(row_perm) || !is_permutation(col_perm)) error = "Corrupted LU permutation";
+        }
+        if (error) {
+            std::cerr << error << std::endl;
+            return false;
+        }
+        row_perm_.assign(row_perm.begin(), row_perm.end());
+        col_perm_.assign(col_perm.begin(), col_perm.end());
+        pivoting_ = Pivoting(header.pivoting);
+        lu_ = Matrix(n, n);
+        for (int i = 0; i < n; i++) std::copy(lu[i], lu[i] + n, lu_[i]);
+        work_.resize(n);
+        return true;
+    }
+
+private:
+    // Каждое из чисел 0 .. n - 1 встречается ровно один раз
+    static bool is_permutation(const std::vector<std::int32_t>& perm)
+    {
+        std::vector<char> seen(perm.size(), 0);
+        for (std::int32_t p : perm) {
+            if (p < 0 || std::size_t(p) >= perm.size() || seen[p]) return false;
+            seen[p] = 1;
+        }
+        return true;
+    }
+
+    Matrix lu_;
+    std::vector<int> row_perm_;
+    std::vector<int> col_perm_;
+    Pivoting pivoting_;
+    mutable std::vector<double> work_;
+};
+
+// Число шагов уточнения для разложения в смешанной точности по умолчанию
+const int MIXED_REFINE_ITERATIONS = 10;
+
+// LU-разложение в смешанной точности: матрица раскладывается во float
+// (вдвое меньше памяти и вдвое шире векторные операции), а точность
+// double восстанавливается итерационным уточнением: невязка r = b - A x
+// считается в double по исходной матрице, поправка находится по
+// float-разложению. Сходится, если число обусловленности A заметно меньше
+// 1 / eps_float ~ 1e7.
+class MixedPrecisionLU
+{
+public:
+    MixedPrecisionLU() {}
+
+    explicit MixedPrecisionLU(ConstMatrixView A, ThreadPool* pool = nullptr)
+    {
+        factor(A, pool);
+    }
+
+    void factor(ConstMatrixView A, ThreadPool* pool = nullptr)
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        int n = A.rows();
+        lu_ = BasicMatrix<float>(n, n);
+        for (int i = 0; i < n; i++) std::copy(A[i], A[i] + n, lu_[i]);
+        if (pool) LU_factor_parallel(lu_.view(), &perm_, *pool);
+        else LU_factor_blocked(lu_.view(), &perm_);
+        work_.resize(n);
+    }
+
+    int size() const { return lu_.rows(); }
+    const BasicMatrix<float>& lu() const { return lu_; }
+    const std::vector<int>& perm() const { return perm_; }
+
+    // Решение A d = r только по float-разложению (точность ~1e-7).
+    // r масштабируется на max|r|, чтобы малые невязки не уходили в
+    // денормализованные числа float.
+    void solve_low_precision(const double* r, double* d) const
+    {
+        int n = size();
+        double scale = max_abs(r, n);
+        if (scale == 0.0) {
+            std::fill(d, d + n, 0.0);
+            return;
+        }
+        for (int i = 0; i < n; i++) work_[i] = float(r[perm_[i]] / scale);
+        LU_substitute<float>(lu_, lu_, work_.data());
+        for (int i = 0; i < n; i++) d[i] = double(work_[i]) * scale;
+    }
+
+    // Решение A x = b с точностью double. A - исходная матрица в double.
+    // Уточнение останавливается, когда max|r| <= tolerance, когда невязка
+    // перестаёт уменьшаться хотя бы вдвое или после max_iterations
+    // поправок. Если последняя поправка увеличила невязку (застой или
+    // расходимость при обусловленности около 1 / eps_float), возвращается
+    // предыдущее приближение. Если history != nullptr, туда записывается
+    // max|r| перед каждым шагом уточнения и после последнего.
+    std::vector<double> solve(ConstMatrixView A, const std::vector<double>& b, std::vector<double>* history = nullptr,
+                              int max_iterations = MIXED_REFINE_ITERATIONS, double tolerance = 0.0) const
+    {
+        int n = size();
+        if (A.rows() != n || int(b.size()) != n) throw "Matrix and vector sizes doesnt match";
+        if (history) history->clear();
+        std::vector<double> x(n), r(n), d(n), x_prev;
+        solve_low_precision(b.data(), x.data());
+        double prev = 0.0;
+        for (int it = 0; ; it++) {
+            residual(A, x.data(), b.data(), r.data());
+            double norm = max_abs(r.data(), n);
+            if (history) history->push_back(norm);
+            if (it > 0 && norm > prev) {
+                x.swap(x_prev);
+                break;
+            }
+            if (it == max_iterations || norm <= tolerance || (it > 0 && norm > 0.5 * prev)) break;
+            prev = norm;
+            solve_low_precision(r.data(), d.data());
+            x_prev = x;
+            axpy(n, 1.0, d.data(), x.data());
+        }
+        return x;
+    }
+
+private:
+    BasicMatrix<float> lu_;
+    std::vector<int> perm_;
+    mutable std::vector<float> work_;
+};
+
 // Функция для умножения матрицы на столбец
-std::vector<double> matrix_vector_multiply(const std::vector<std::vector<double>>& matrix, const std::vector<double>& vector)
+std::vector<double> matrix_vector_multiply(ConstMatrixView matrix, const std::vector<double>& vector)
+{
+    if (matrix.cols() != int(vector.size())) throw "Matrix and vector sizes doesnt match";
+    std::vector<double> result(matrix.rows());
+    gemv(matrix, vector.data(), result.data());
+    return result;
+}
+
+// Умножение матрицы на столбец с записью в буфер вызывающего, без выделения памяти
+void matrix_vector_multiply(ConstMatrixView matrix, const std::vector<double>& vector, std::vector<double>& result)
+{
+    if (matrix.cols() != int(vector.size())) throw "Matrix and vector sizes doesnt match";
+    result.resize(matrix.rows());
+    gemv(matrix, vector.data(), result.data());
+}
+
+// Произведение матриц A * B блочным gemm; с пулом - многопоточно
+Matrix matrix_multiply(ConstMatrixView A, ConstMatrixView B, ThreadPool *pool = nullptr)
+{
+    if (A.cols() != B.rows()) throw "Matrix sizes doesnt match";
+    Matrix C(A.rows(), B.cols());
+    if (pool) gemm(1.0, A, B, C.view(), *pool);
+    else gemm(1.0, A, B, C.view());
+    return C;
+}
+
+// Разбор одной строки CSV [begin, end) в row из cols элементов.
+// std::from_chars не зависит от локали и не выделяет память.
+void parse_csv_row(const char *begin, const char *end, double *row, int cols)
+{
+    const char *p = begin;
+    for (int j = 0; j < cols; j++) {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        if (p < end && *p == '+') ++p;
+        std::from_chars_result res = std::from_chars(p, end, row[j]);
+        if (res.ec != std::errc()) throw "Incorrect number in csv file";
+        p = res.ptr;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+        if (j + 1 < cols) {
+            if (p == end || *p != ',') throw "Rows in csv file have different lengths";
+            ++p;
+        }
+    }
+    if (p != end) throw "Rows in csv file have different lengths";
+}
+
+// Границы непустых строк текста [data, end) без завершающих '\r' и пробелов
+void split_lines(const char *data, const char *end, std::vector<const char *>& line_begin, std::vector<const char *>& line_end)
+{
+    for (const char *p = data; p < end;) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        const char *last = eol;
+        while (last > p && (last[-1] == '\r' || last[-1] == ' ')) --last;
+        if (last > p) {
+            line_begin.push_back(p);
+            line_end.push_back(last);
+        }
+        p = eol + 1;
+    }
+}
+
+// Чтение матрицы из CSV: файл отображается в память, находятся начала
+// строк, затем строки разбираются прямо в заранее выделенную матрицу.
+// Если передан пул, диапазоны строк разбираются параллельно.
+Matrix read_csv(const std::string& filename, ThreadPool* pool)
 {
-    int rows = matrix.size();
-    int cols = matrix[0].size();
-    std::vector<double> result(rows, 0);
+    PROFILE_SCOPE("read_csv");
+    MappedFile file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error when try to open file" << std::endl;
+        return Matrix();
+    }
+    PROFILE_BYTES(double(file.size()));
+    std::vector<const char *> line_begin, line_end;
+    split_lines(file.data(), file.data() + file.size(), line_begin, line_end);
+    int rows = int(line_begin.size());
+    if (rows == 0) return Matrix();
+    int cols = int(std::count(line_begin[0], line_end[0], ',')) + 1;
+
+    Matrix matrix(rows, cols);
+    auto parse_rows = [&](int first, int last) {
+        for (int i = first; i < last; i++) parse_csv_row(line_begin[i], line_end[i], matrix[i], cols);
+    };
+    if (!pool || pool->size() == 1) {
+        parse_rows(0, rows);
+    } else {
+        int chunks = std::min(rows, pool->size() * 4);
+        for (int c = 0; c < chunks; c++) {
+            int first = int(std::int64_t(rows) * c / chunks);
+            int last = int(std::int64_t(rows) * (c + 1) / chunks);
+            pool->submit([&parse_rows, first, last] { parse_rows(first, last); });
+        }
+        pool->wait();
+    }
+    return matrix;
+}
+
+Matrix read_csv(const std::string& filename)
+{
+    return read_csv(filename, nullptr);
+}
+
+// Чтение разреженной матрицы из CSV сразу в CSR: строки разбираются по
+// одной во временный буфер, и в матрицу попадают только элементы с
+// |a_ij| > drop_tolerance, так что плотная матрица целиком в памяти не
+// появляется. При ошибке открытия возвращается пустая матрица.
+CSRMatrix read_csv_sparse(const std::string& filename, double drop_tolerance = 0.0)
+{
+    MappedFile file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error when try to open file" << std::endl;
+        return CSRMatrix();
+    }
+    std::vector<const char *> line_begin, line_end;
+    split_lines(file.data(), file.data() + file.size(), line_begin, line_end);
+    int rows = int(line_begin.size());
+    if (rows == 0) return CSRMatrix();
+    int cols = int(std::count(line_begin[0], line_end[0], ',')) + 1;
+
+    std::vector<double> row(cols);
+    std::vector<int> row_ptr(rows + 1, 0), col_index;
+    std::vector<double> values;
     for (int i = 0; i < rows; i++) {
+        parse_csv_row(line_begin[i], line_end[i], row.data(), cols);
         for (int j = 0; j < cols; j++) {
-            result[i] += matrix[i][j] * vector[j];
+            if (std::fabs(row[j]) > drop_tolerance) {
+                col_index.push_back(j);
+                values.push_back(row[j]);
+            }
         }
+        row_ptr[i + 1] = int(values.size());
     }
-    return result;
+    return CSRMatrix(rows, cols, std::move(row_ptr), std::move(col_index), std::move(values));
+}
+
+// Следующее слово (до пробельного символа) в [p, end); p сдвигается за него
+std::pair<const char *, const char *> next_token(const char *&p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+    const char *begin = p;
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') ++p;
+    return {begin, p};
 }
 
-std::vector<std::vector<double>> read_csv(const std::string& filename)
+template<typename T>
+T parse_number(const char *&p, const char *end)
 {
-    std::vector<std::vector<double>> matrix;
-    std::ifstream file(filename);
+    std::pair<const char *, const char *> token = next_token(p, end);
+    if (token.first < token.second && *token.first == '+') ++token.first;
+    T value;
+    std::from_chars_result res = std::from_chars(token.first, token.second, value);
+    if (token.first == token.second || res.ec != std::errc() || res.ptr != token.second) {
+        throw "Incorrect number in MatrixMarket file";
+    }
+    return value;
+}
+
+// Чтение матрицы в формате MatrixMarket (.mtx) в CSR. Поддерживаются
+// форматы coordinate и array, поля real, integer и pattern (все элементы
+// равны 1) и симметрии general, symmetric и skew-symmetric (хранимый
+// треугольник отражается). Нули из файла не сохраняются. При ошибке
+// открытия возвращается пустая матрица, при ошибке формата - исключение.
+CSRMatrix read_matrix_market(const std::string& filename)
+{
+    MappedFile file(filename);
     if (!file.is_open()) {
         std::cerr << "Error when try to open file" << std::endl;
-        return matrix;
+        return CSRMatrix();
+    }
+    const char *p = file.data();
+    const char *end = p + file.size();
+
+    // Заголовок: %%MatrixMarket matrix <format> <field> <symmetry>
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!eol) eol = end;
+    std::string banner(p, eol);
+    for (auto &c : banner) c = char(std::tolower(static_cast<unsigned char>(c)));
+    std::vector<std::string> words;
+    for (const char *q = banner.data(), *q_end = q + banner.size(); q < q_end;) {
+        std::pair<const char *, const char *> token = next_token(q, q_end);
+        if (token.first < token.second) words.emplace_back(token.first, token.second);
     }
-    std::string line;
-    while (std::getline(file, line)) {
-        std::vector<double> row;
-        std::stringstream ss(line);
-        std::string cell;
-        while (std::getline(ss, cell, ',')) {
-            row.push_back(std::stod(cell));
+    if (words.size() != 5 || words[0] != "%%matrixmarket" || words[1] != "matrix") throw "Not a MatrixMarket matrix file";
+    bool coordinate = words[2] == "coordinate";
+    if (!coordinate && words[2] != "array") throw "Unsupported MatrixMarket format";
+    bool pattern = words[3] == "pattern";
+    if (words[3] != "real" && words[3] != "integer" && words[3] != "double" && !pattern) throw "Unsupported MatrixMarket field";
+    int mirror = 0;
+    if (words[4] == "symmetric") mirror = 1;
+    else if (words[4] == "skew-symmetric") mirror = -1;
+    else if (words[4] != "general") throw "Unsupported MatrixMarket symmetry";
+    if (pattern && !coordinate) throw "Unsupported MatrixMarket format";
+
+    // Строки комментариев
+    p = eol;
+    while (p < end) {
+        while (p < end && (*p == '\n' || *p == '\r' || *p == ' ' || *p == '\t')) ++p;
+        if (p == end || *p != '%') break;
+        eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        p = eol ? eol : end;
+    }
+
+    int rows = parse_number<int>(p, end), cols = parse_number<int>(p, end);
+    if (rows < 0 || cols < 0 || (mirror != 0 && rows != cols)) throw "Incorrect MatrixMarket matrix size";
+    std::vector<int> I, J;
+    std::vector<double> V;
+    auto add = [&](int i, int j, double v) {
+        if (v == 0.0) return;
+        I.push_back(i), J.push_back(j), V.push_back(v);
+        if (mirror != 0 && i != j) I.push_back(j), J.push_back(i), V.push_back(mirror * v);
+    };
+    if (coordinate) {
+        long long entries = parse_number<long long>(p, end);
+        I.reserve(entries), J.reserve(entries), V.reserve(entries);
+        for (long long k = 0; k < entries; k++) {
+            int i = parse_number<int>(p, end) - 1, j = parse_number<int>(p, end) - 1;
+            add(i, j, pattern ? 1.0 : parse_number<double>(p, end));
+        }
+    } else {
+        // Плотная матрица по столбцам; для симметричных - нижний треугольник
+        // (для кососимметричных - без диагонали)
+        for (int j = 0; j < cols; j++) {
+            int first = mirror == 0 ? 0 : (mirror > 0 ? j : j + 1);
+            for (int i = first; i < rows; i++) add(i, j, parse_number<double>(p, end));
         }
-        matrix.push_back(row);
     }
-    return matrix;
+    return csr_from_triplets(rows, cols, I, J, V);
+}
+
+// Перевод CSV в двоичный формат (matrix_file.h), чтобы при следующих
+// запусках матрица загружалась отображением файла в память
+bool convert_csv_to_binary(const std::string& csv_filename, const std::string& binary_filename, ThreadPool* pool = nullptr)
+{
+    Matrix A = read_csv(csv_filename, pool);
+    if (A.empty()) return false;
+    return write_matrix_binary(binary_filename, A);
 }
 
-double max_norm(const std::vector<double> v)
+// Проверка симметричности: |a_ij - a_ji| <= tolerance * max(|a_ij|, |a_ji|)
+bool is_symmetric(ConstMatrixView A, double tolerance = 0.0)
 {
-    double max = fabs(v.at(0));
-    for (auto &it : v) {
-        max = (max > fabs(it)) ? max : fabs(it);
+    if (A.rows() != A.cols()) return false;
+    for (int i = 0; i < A.rows(); i++) {
+        const double *Ai = A[i];
+        for (int j = i + 1; j < A.cols(); j++) {
+            double aij = Ai[j], aji = A[j][i];
+            if (std::fabs(aij - aji) > tolerance * std::max(std::fabs(aij), std::fabs(aji))) return false;
+        }
     }
-    return max;
+    return true;
 }
 
-std::vector<double> operator-(const std::vector<double> &v1, const std::vector<double> &v2)
+// Ленточный решатель выбирается, если kl + ku + 1 не больше этой доли n:
+// тогда O(n kl (kl + ku)) много меньше O(n^3) плотного разложения
+const double BAND_MAX_FRACTION = 0.1;
+
+// Прямой решатель, выбирающий разложение по матрице сразу после загрузки
+// (проверки за O(n^2), до разложения за O(n^3)):
+//   - трёхдиагональная с диагональным преобладанием - прогонка, а с пулом
+//     и на длинной системе - параллельная циклическая редукция;
+//   - узкая лента - ленточное LU (ширина ленты ищется по нулям матрицы);
+//   - симметричная - разложение Холецкого или LDL^T по нижнему треугольнику;
+//   - остальные - LU с выбором ведущего элемента по столбцу.
+//   DirectSolver solver(read_csv(filename));
+//   std::vector<double> x = solver.solve(b);
+class DirectSolver
 {
-    if (v1.size() != v2.size()) throw "Incorrect sizes!!!\n";
-    std::vector<double> ans(v2.size());
-    for (int i = 0; i < v1.size(); ++i) {
-        ans[i] = v1[i] - v2[i];
+public:
+    enum Method
+    {
+        DENSE_LU,
+        SYMMETRIC,
+        BANDED,
+        TRIDIAGONAL
+    };
+
+    explicit DirectSolver(ConstMatrixView A, double symmetry_tolerance = 0.0, ThreadPool* pool = nullptr)
+        : pool_(pool)
+    {
+        PROFILE_SCOPE("DirectSolver::factor");
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        int n = A.rows();
+        int kl = lower_bandwidth(A), ku = upper_bandwidth(A);
+        if (n > 2 && kl <= 1 && ku <= 1 && (tridiagonal_ = Tridiagonal(A)).diagonally_dominant()) {
+            method_ = TRIDIAGONAL;
+        } else if (kl + ku + 1 <= BAND_MAX_FRACTION * n) {
+            method_ = BANDED;
+            band_.factor(A, kl, ku);
+        } else if (is_symmetric(A, symmetry_tolerance)) {
+            method_ = SYMMETRIC;
+            symmetric_.factor(A);
+        } else {
+            method_ = DENSE_LU;
+            lu_.factor(A, PARTIAL_PIVOTING, pool);
+        }
+        if (method_ != TRIDIAGONAL) tridiagonal_ = Tridiagonal();
+    }
+
+    Method method() const { return method_; }
+    bool symmetric() const { return method_ == SYMMETRIC; }
+
+    // Название выбранного метода
+    const char *method_name() const
+    {
+        switch (method_) {
+        case TRIDIAGONAL:
+            return use_cyclic_reduction() ? "cyclic reduction" : "Thomas";
+        case BANDED:
+            return "banded LU";
+        case SYMMETRIC:
+            return symmetric_.method() == CHOLESKY ? "Cholesky" : "LDLT";
+        default:
+            return "LU";
+        }
+    }
+
+    void solve(const std::vector<double>& b, std::vector<double>& x) const
+    {
+        PROFILE_SCOPE("DirectSolver::solve");
+        switch (method_) {
+        case TRIDIAGONAL:
+            x = use_cyclic_reduction() ? cyclic_reduction_solve(tridiagonal_, b, pool_) : thomas_solve(tridiagonal_, b);
+            break;
+        case BANDED:
+            band_.solve(b, x);
+            break;
+        case SYMMETRIC:
+            symmetric_.solve(b, x);
+            break;
+        default:
+            lu_.solve(b, x);
+        }
     }
-    return ans;
+
+    std::vector<double> solve(const std::vector<double>& b) const
+    {
+        std::vector<double> x;
+        solve(b, x);
+        return x;
+    }
+
+private:
+    // Редукция окупается, только если каждому потоку достаётся несколько кусков
+    bool use_cyclic_reduction() const
+    {
+        return pool_ && pool_->size() > 1 && tridiagonal_.size() >= 4 * CYCLIC_REDUCTION_CHUNK * pool_->size();
+    }
+
+    Method method_;
+    ThreadPool* pool_;
+    Tridiagonal tridiagonal_;
+    BandFactorization band_;
+    SymmetricFactorization symmetric_;
+    LUFactorization lu_;
+};
+
+double max_norm(const std::vector<double>& v)
+{
+    if (v.empty()) throw std::out_of_range("max_norm of empty vector");
+    return max_abs(v.data(), int(v.size()));
 }
 
 std::vector<double> generate_random_vect(int s)
@@ -124,23 +1197,24 @@ std::vector<double> generate_random_vect(int s)
 // int main()
 // {
 //     std::string filename = "./SLAU_var_2.csv";
-//     std::vector<std::vector<double>> A = read_csv(filename);
+//     Matrix A = read_csv(filename);
     
-//     // LU-разложение
-//     std::vector<std::vector<double>> L;
-//     std::vector<std::vector<double>> U;
-//     std::vector<std::vector<double>> tmp_A = A;
-//     LU_decomposition(tmp_A, L, U);
+//     // LU-разложение (сохраняется, чтобы не повторять его при следующем запуске)
+//     LUFactorization lu;
+//     if (!lu.load("./SLAU_var_2.lu")) {
+//         lu.factor(A);
+//         lu.save("./SLAU_var_2.lu");
+//     }
 
 //     // генерация решения
-//     std::vector<double> x = generate_random_vect(A.size());
+//     std::vector<double> x = generate_random_vect(A.rows());
 
 //     // Вычисление правой части системы
 //     std::vector<double> f = matrix_vector_multiply(A, x);
 
 //     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 //     // Решение системы линейных уравнений
-//     std::vector<double> x_computed = solve_system(L, U, f);
+//     std::vector<double> x_computed = lu.solve(f);
 //     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 
 //     std::cout << "||x_true - x_computed|| = " << max_norm(x - x_computed) << std::endl;
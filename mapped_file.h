@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Файл, отображённый в память только для чтения (mmap). Содержимое
+// доступно через data()/size() без копирования в буфер процесса;
+// отображение снимается в деструкторе.
+class MappedFile
+{
+public:
+    MappedFile() : data_(nullptr), size_(0), is_open_(false) {}
+
+    explicit MappedFile(const std::string &filename) : MappedFile()
+    {
+        open(filename);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept : MappedFile()
+    {
+        swap(other);
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~MappedFile() { close(); }
+
+    void swap(MappedFile &other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(is_open_, other.is_open_);
+    }
+
+    // Возвращает false, если файл не удалось открыть или отобразить
+    bool open(const std::string &filename)
+    {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = std::size_t(st.st_size);
+        if (size_ != 0) {
+            void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            data_ = static_cast<const char *>(p);
+            madvise(p, size_, MADV_SEQUENTIAL);
+        }
+        // Отображение остаётся действительным и после закрытия дескриптора
+        ::close(fd);
+        is_open_ = true;
+        return true;
+    }
+
+    void close()
+    {
+        if (data_) munmap(const_cast<char *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+        is_open_ = false;
+    }
+
+    bool is_open() const { return is_open_; }
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char *data_;
+    std::size_t size_;
+    bool is_open_;
+};
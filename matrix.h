@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+// Выравнивание буфера матрицы в байтах (строка кэша, ширина регистра AVX-512)
+const std::size_t MATRIX_ALIGNMENT = 64;
+
+// Невладеющее представление (view) плотной матрицы, хранящейся по строкам.
+// Элемент (i, j) лежит по адресу data + i * stride + j, поэтому view может
+// указывать как на всю матрицу, так и на её прямоугольный блок.
+template<typename T>
+class BasicMatrixView
+{
+public:
+    BasicMatrixView() : data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+    BasicMatrixView(T *data, int rows, int cols, int stride)
+        : data_(data), rows_(rows), cols_(cols), stride_(stride) {}
+
+    // Неявное преобразование view<double> -> view<const double>
+    template<typename U,
+             typename = typename std::enable_if<!std::is_same<U, T>::value &&
+                                                std::is_same<const U, T>::value>::type>
+    BasicMatrixView(const BasicMatrixView<U> &other)
+        : data_(other.data()), rows_(other.rows()), cols_(other.cols()), stride_(other.stride()) {}
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int stride() const { return stride_; }
+    T *data() const { return data_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+    T &operator()(int i, int j) const { return data_[std::ptrdiff_t(i) * stride_ + j]; }
+    // Указатель на начало i-й строки, чтобы работала запись A[i][j]
+    T *operator[](int i) const { return data_ + std::ptrdiff_t(i) * stride_; }
+
+    // Блок размера r x c с левым верхним углом в (i, j)
+    BasicMatrixView block(int i, int j, int r, int c) const
+    {
+        return BasicMatrixView(data_ + std::ptrdiff_t(i) * stride_ + j, r, c, stride_);
+    }
+
+private:
+    T *data_;
+    int rows_;
+    int cols_;
+    int stride_;
+};
+
+// Плотная матрица в одном непрерывном выровненном буфере.
+// Длина строки (stride) дополняется до кратной MATRIX_ALIGNMENT, так что
+// начало каждой строки тоже выровнено; хвост строки заполнен нулями.
+template<typename T>
+class BasicMatrix
+{
+public:
+    BasicMatrix() : data_(nullptr), rows_(0), cols_(0), stride_(0) {}
+
+    BasicMatrix(int rows, int cols, T value = T()) : BasicMatrix()
+    {
+        resize(rows, cols, value);
+    }
+
+    BasicMatrix(const BasicMatrix &other) : BasicMatrix()
+    {
+        allocate(other.rows_, other.cols_);
+        std::copy(other.data_, other.data_ + size_in_elements(), data_);
+    }
+
+    BasicMatrix(BasicMatrix &&other) noexcept
+        : data_(other.data_), rows_(other.rows_), cols_(other.cols_), stride_(other.stride_)
+    {
+        other.data_ = nullptr;
+        other.rows_ = other.cols_ = other.stride_ = 0;
+    }
+
+    BasicMatrix &operator=(BasicMatrix other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~BasicMatrix() { release(); }
+
+    void swap(BasicMatrix &other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(rows_, other.rows_);
+        std::swap(cols_, other.cols_);
+        std::swap(stride_, other.stride_);
+    }
+
+    // Матрица без инициализации элементов (и хвостов строк). Страницы
+    // памяти ещё не тронуты, поэтому на NUMA-системе каждая попадёт в узел
+    // того потока, который первым запишет в неё (first touch).
+    static BasicMatrix uninitialized(int rows, int cols)
+    {
+        BasicMatrix matrix;
+        matrix.allocate(rows, cols);
+        return matrix;
+    }
+
+    // Пересоздаёт матрицу заданного размера, все элементы равны value
+    void resize(int rows, int cols, T value = T())
+    {
+        allocate(rows, cols);
+        for (int i = 0; i < rows_; ++i) {
+            T *row = (*this)[i];
+            std::fill(row, row + cols_, value);
+            std::fill(row + cols_, row + stride_, T());
+        }
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int stride() const { return stride_; }
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+    T &operator()(int i, int j) { return data_[std::ptrdiff_t(i) * stride_ + j]; }
+    const T &operator()(int i, int j) const { return data_[std::ptrdiff_t(i) * stride_ + j]; }
+    T *operator[](int i) { return data_ + std::ptrdiff_t(i) * stride_; }
+    const T *operator[](int i) const { return data_ + std::ptrdiff_t(i) * stride_; }
+
+    BasicMatrixView<T> view() { return BasicMatrixView<T>(data_, rows_, cols_, stride_); }
+    BasicMatrixView<const T> view() const { return BasicMatrixView<const T>(data_, rows_, cols_, stride_); }
+    BasicMatrixView<T> block(int i, int j, int r, int c) { return view().block(i, j, r, c); }
+    BasicMatrixView<const T> block(int i, int j, int r, int c) const { return view().block(i, j, r, c); }
+
+    operator BasicMatrixView<T>() { return view(); }
+    operator BasicMatrixView<const T>() const { return view(); }
+
+private:
+    static int padded_stride(int cols)
+    {
+        const int lanes = int(MATRIX_ALIGNMENT / sizeof(T));
+        return (cols + lanes - 1) / lanes * lanes;
+    }
+
+    std::size_t size_in_elements() const { return std::size_t(rows_) * stride_; }
+
+    void allocate(int rows, int cols)
+    {
+        if (rows < 0 || cols < 0) throw "Matrix sizes should be non-negative";
+        release();
+        rows_ = rows, cols_ = cols, stride_ = padded_stride(cols);
+        if (size_in_elements() != 0) {
+            data_ = static_cast<T *>(::operator new(size_in_elements() * sizeof(T),
+                                                    std::align_val_t(MATRIX_ALIGNMENT)));
+        }
+    }
+
+    void release()
+    {
+        if (data_) ::operator delete(data_, std::align_val_t(MATRIX_ALIGNMENT));
+        data_ = nullptr;
+        rows_ = cols_ = stride_ = 0;
+    }
+
+    T *data_;
+    int rows_;
+    int cols_;
+    int stride_;
+};
+
+typedef BasicMatrix<double> Matrix;
+typedef BasicMatrixView<double> MatrixView;
+typedef BasicMatrixView<const double> ConstMatrixView;
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "mapped_file.h"
+
+// Двоичный формат матрицы:
+//   заголовок MatrixFileHeader (64 байта),
+//   данные rows x stride элементов по строкам, хвосты строк заполнены нулями.
+// Данные начинаются со смещения 64, а stride совпадает с шагом Matrix,
+// поэтому при отображении файла в память строки выровнены так же, как в
+// Matrix, и матрицу можно использовать без копирования.
+// Числа записываются в порядке байт машины (little-endian на x86).
+
+const char MATRIX_FILE_MAGIC[8] = {'C', 'H', 'M', 'Y', 'M', 'A', 'T', '\0'};
+const std::uint32_t MATRIX_FILE_VERSION = 1;
+
+enum MatrixDtype
+{
+    DTYPE_FLOAT64 = 1,
+    DTYPE_FLOAT32 = 2
+};
+
+enum MatrixLayout
+{
+    LAYOUT_ROW_MAJOR = 0
+};
+
+struct MatrixFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t dtype;
+    std::uint32_t layout;
+    std::uint32_t data_offset;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t stride;
+    std::uint64_t checksum;
+    std::uint8_t reserved[8];
+};
+static_assert(sizeof(MatrixFileHeader) == MATRIX_ALIGNMENT, "Matrix file header should be 64 bytes");
+
+template<typename T> inline std::uint32_t matrix_dtype();
+template<> inline std::uint32_t matrix_dtype<double>() { return DTYPE_FLOAT64; }
+template<> inline std::uint32_t matrix_dtype<float>() { return DTYPE_FLOAT32; }
+
+// Контрольная сумма данных: FNV-1a по 64-битным словам
+// (размер данных всегда кратен 8 байтам)
+inline std::uint64_t matrix_checksum(const void *data, std::size_t bytes, std::uint64_t h = 14695981039346656037ULL)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i + 8 <= bytes; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = (h ^ word) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// Запись матрицы в двоичном формате в поток (заголовок и данные)
+template<typename T>
+bool write_matrix_binary(std::ostream &out, BasicMatrixView<const T> A)
+{
+    const int lanes = int(MATRIX_ALIGNMENT / sizeof(T));
+    int stride = (A.cols() + lanes - 1) / lanes * lanes;
+    std::vector<T> row(stride, T());
+
+    MatrixFileHeader header = {};
+    std::memcpy(header.magic, MATRIX_FILE_MAGIC, sizeof(header.magic));
+    header.version = MATRIX_FILE_VERSION;
+    header.dtype = matrix_dtype<T>();
+    header.layout = LAYOUT_ROW_MAJOR;
+    header.data_offset = sizeof(MatrixFileHeader);
+    header.rows = A.rows();
+    header.cols = A.cols();
+    header.stride = stride;
+    header.checksum = matrix_checksum(nullptr, 0);
+    for (int i = 0; i < A.rows(); ++i) {
+        std::copy(A[i], A[i] + A.cols(), row.begin());
+        header.checksum = matrix_checksum(row.data(), row.size() * sizeof(T), header.checksum);
+    }
+
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (int i = 0; i < A.rows(); ++i) {
+        std::copy(A[i], A[i] + A.cols(), row.begin());
+        out.write(reinterpret_cast<const char *>(row.data()), std::streamsize(row.size() * sizeof(T)));
+    }
+    return bool(out);
+}
+
+// Запись матрицы в двоичный файл. Возвращает false при ошибке записи.
+template<typename T>
+bool write_matrix_binary(const std::string &filename, BasicMatrixView<const T> A)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error when try to open file" << std::endl;
+        return false;
+    }
+    return write_matrix_binary<T>(file, A);
+}
+
+template<typename T>
+bool write_matrix_binary(const std::string &filename, const BasicMatrix<T> &A)
+{
+    return write_matrix_binary<T>(filename, A.view());
+}
+
+// Разбор матрицы в двоичном формате, лежащей в памяти по адресу data
+// (адрес должен быть выровнен по MATRIX_ALIGNMENT). При успехе view
+// указывает на данные и возвращается nullptr, иначе - текст ошибки.
+template<typename T>
+const char *parse_matrix_binary(const char *data, std::size_t size, bool verify_checksum, BasicMatrixView<const T> &view)
+{
+    MatrixFileHeader header;
+    if (size < sizeof(header)) return "File is too small for matrix header";
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MATRIX_FILE_MAGIC, sizeof(header.magic)) != 0) return "Not a matrix file";
+    if (header.version != MATRIX_FILE_VERSION) return "Unsupported matrix file version";
+    if (header.dtype != matrix_dtype<T>()) return "Matrix file has another element type";
+    if (header.layout != LAYOUT_ROW_MAJOR) return "Unsupported matrix layout";
+    if (header.data_offset % MATRIX_ALIGNMENT != 0 || header.stride < header.cols) return "Corrupted matrix header";
+    // Размеры должны помещаться в int, а произведения и сумма ниже - не переполняться
+    const std::uint64_t int_max = std::uint64_t(std::numeric_limits<int>::max());
+    if (header.rows > int_max || header.cols > int_max || header.stride > int_max) return "Corrupted matrix header";
+    if (header.data_offset > size) return "Matrix file is truncated";
+    if (header.rows != 0 && header.stride > (size - header.data_offset) / header.rows / sizeof(T)) return "Matrix file is truncated";
+    std::uint64_t bytes = header.rows * header.stride * sizeof(T);
+    const char *values = data + header.data_offset;
+    if (verify_checksum && matrix_checksum(values, bytes) != header.checksum) return "Matrix file checksum mismatch";
+    view = BasicMatrixView<const T>(reinterpret_cast<const T *>(values), int(header.rows), int(header.cols), int(header.stride));
+    return nullptr;
+}
+
+// Матрица из двоичного файла, отображённого в память. Данные не
+// копируются: view() указывает прямо в отображение, поэтому матрица
+// доступна только для чтения и живёт, пока жив объект.
+template<typename T>
+class BasicMappedMatrix
+{
+public:
+    BasicMappedMatrix() {}
+
+    // Возвращает false (с сообщением в cerr), если файл не открылся или
+    // заголовок не подходит. При verify_checksum данные читаются целиком
+    // и сверяются с контрольной суммой из заголовка.
+    bool open(const std::string &filename, bool verify_checksum = false)
+    {
+        view_ = BasicMatrixView<const T>();
+        if (!file_.open(filename)) {
+            std::cerr << "Error when try to open file" << std::endl;
+            return false;
+        }
+        const char *error = parse_matrix_binary(file_.data(), file_.size(), verify_checksum, view_);
+        if (error) {
+            std::cerr << error << std::endl;
+            file_.close();
+            return false;
+        }
+        return true;
+    }
+
+    BasicMatrixView<const T> view() const { return view_; }
+    operator BasicMatrixView<const T>() const { return view_; }
+    int rows() const { return view_.rows(); }
+    int cols() const { return view_.cols(); }
+
+private:
+    MappedFile file_;
+    BasicMatrixView<const T> view_;
+};
+
+typedef BasicMappedMatrix<double> MappedMatrix;
+
+// Чтение двоичного файла в обычную (изменяемую) матрицу, например для
+// LU-разложения на месте. При ошибке возвращается пустая матрица.
+template<typename T>
+BasicMatrix<T> read_matrix_binary(const std::string &filename, bool verify_checksum = false)
+{
+    BasicMappedMatrix<T> mapped;
+    if (!mapped.open(filename, verify_checksum)) return BasicMatrix<T>();
+    BasicMatrixView<const T> src = mapped.view();
+    BasicMatrix<T> A(src.rows(), src.cols());
+    for (int i = 0; i < src.rows(); ++i) std::copy(src[i], src[i] + src.cols(), A[i]);
+    return A;
+}
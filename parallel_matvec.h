@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "matrix.h"
+#include "thread_pool.h"
+#include "vector_ops.h"
+#include "sparse_matrix.h"
+
+// Умножение матрицы на вектор по строкам на постоянном пуле потоков и
+// совмещённый с ним шаг метода Чебышева.
+
+// Границы parts непрерывных диапазонов строк [bounds[t], bounds[t + 1]).
+// Границы кратны 8 строкам, чтобы потоки не писали в одну строку кэша y.
+inline std::vector<int> row_partition(int rows, int parts)
+{
+    std::vector<int> bounds(parts + 1, rows);
+    for (int t = 0; t < parts; ++t) {
+        bounds[t] = std::min(rows, int(std::int64_t(rows) * t / parts) / 8 * 8);
+    }
+    return bounds;
+}
+
+// Шаг метода Чебышева для строк [first, last) за один проход по A:
+//   r = F - A x,  d = a * d + b * r,  x_next = x + d.
+// Возвращает сумму r_i^2 по этим строкам. При a = 0, b = tau это
+// x_next = x + tau * (F - A x). x_next не должен совпадать с x: другие
+// строки ещё читают x.
+inline double chebyshev_update_rows(ConstMatrixView A, int first, int last, const double *x, const double *F,
+                                    double a, double b, double *r, double *d, double *x_next)
+{
+    const VectorKernels &k = vector_kernels();
+    double sum = 0;
+    for (int i = first; i < last; ++i) {
+        double ri = F[i] - k.dot(A[i], x, A.cols());
+        r[i] = ri;
+        d[i] = a * d[i] + b * ri;
+        x_next[i] = x[i] + d[i];
+        sum += ri * ri;
+    }
+    return sum;
+}
+
+inline double chebyshev_update(const Matrix &A, const double *x, const double *F,
+                               double a, double b, double *r, double *d, double *x_next)
+{
+    return chebyshev_update_rows(A.view(), 0, A.rows(), x, F, a, b, r, d, x_next);
+}
+
+// Для CSR невязка считается блоками по 256 строк, и блок обновляется,
+// пока он ещё в кэше L1
+inline double chebyshev_update(const CSRMatrix &A, const double *x, const double *F,
+                               double a, double b, double *r, double *d, double *x_next)
+{
+    const SparseKernels &k = sparse_kernels();
+    double sum = 0;
+    for (int i0 = 0; i0 < A.rows(); i0 += 256) {
+        int i1 = std::min(A.rows(), i0 + 256);
+        k.csr_gemv(i1 - i0, A.row_ptr().data() + i0, A.col_index().data(), A.values().data(), x, F + i0, r + i0);
+        for (int i = i0; i < i1; ++i) {
+            d[i] = a * d[i] + b * r[i];
+            x_next[i] = x[i] + d[i];
+            sum += r[i] * r[i];
+        }
+    }
+    return sum;
+}
+
+// Для остальных типов матриц - невязка и отдельный проход по векторам
+template<typename MatrixType>
+double chebyshev_update(const MatrixType &A, const double *x, const double *F,
+                        double a, double b, double *r, double *d, double *x_next)
+{
+    residual(A, x, F, r);
+    double sum = 0;
+    for (int i = 0; i < A.rows(); ++i) {
+        d[i] = a * d[i] + b * r[i];
+        x_next[i] = x[i] + d[i];
+        sum += r[i] * r[i];
+    }
+    return sum;
+}
+
+// Плотная матрица, строки которой поделены между потоками пула: поток t
+// всегда обрабатывает строки [bounds[t], bounds[t + 1]) (задачи
+// закрепляются через submit_to), поэтому потоки не создаются на каждой
+// итерации, а строки остаются в кэше своего потока. Матрица копируется
+// в память без инициализации, и каждый поток сам записывает свои строки
+// (first touch): на NUMA-системе они оказываются в узле этого потока.
+// Подставляется в итерационные методы вместо Matrix.
+class ParallelMatrix
+{
+public:
+    ParallelMatrix(ConstMatrixView A, ThreadPool &pool)
+        : pool_(&pool), matrix_(Matrix::uninitialized(A.rows(), A.cols())),
+          bounds_(row_partition(A.rows(), pool.size())), partial_(pool.size())
+    {
+        Matrix &M = matrix_;
+        for_each_part([&A, &M](int, int first, int last) {
+            for (int i = first; i < last; ++i) {
+                std::copy(A[i], A[i] + A.cols(), M[i]);
+                std::fill(M[i] + M.cols(), M[i] + M.stride(), 0.0);
+            }
+        });
+    }
+
+    int rows() const { return matrix_.rows(); }
+    int cols() const { return matrix_.cols(); }
+    ConstMatrixView view() const { return matrix_.view(); }
+    ThreadPool &pool() const { return *pool_; }
+    int parts() const { return int(bounds_.size()) - 1; }
+    const std::vector<int> &bounds() const { return bounds_; }
+
+    // Вызывает f(t, first, last) для каждой части в её потоке и ждёт завершения
+    template<typename F>
+    void for_each_part(F f) const
+    {
+        for (int t = 0; t < parts(); ++t) {
+            int first = bounds_[t], last = bounds_[t + 1];
+            pool_->submit_to(t, [&f, t, first, last] { f(t, first, last); });
+        }
+        pool_->wait();
+    }
+
+    // Сумма значений f(t, first, last) по частям
+    template<typename F>
+    double sum_over_parts(F f) const
+    {
+        PartialSum *partial = partial_.data();
+        for_each_part([&f, partial](int t, int first, int last) { partial[t].value = f(t, first, last); });
+        double sum = 0;
+        for (int t = 0; t < parts(); ++t) sum += partial_[t].value;
+        return sum;
+    }
+
+private:
+    // Частичные суммы потоков в отдельных строках кэша
+    struct alignas(64) PartialSum
+    {
+        double value;
+    };
+
+    ThreadPool *pool_;
+    Matrix matrix_;
+    std::vector<int> bounds_;
+    mutable std::vector<PartialSum> partial_;
+};
+
+// y = A x, каждая часть строк - в своём потоке
+inline void gemv(const ParallelMatrix &A, const double *x, double *y)
+{
+    ConstMatrixView M = A.view();
+    A.for_each_part([M, x, y](int, int first, int last) {
+        gemv(M.block(first, 0, last - first, M.cols()), x, y + first);
+    });
+}
+
+// Невязка r = f - A x (r не должен совпадать с x)
+inline void residual(const ParallelMatrix &A, const double *x, const double *f, double *r)
+{
+    ConstMatrixView M = A.view();
+    A.for_each_part([M, x, f, r](int, int first, int last) {
+        residual(M.block(first, 0, last - first, M.cols()), x, f + first, r + first);
+    });
+}
+
+// Совмещённый шаг метода Чебышева (см. chebyshev_update_rows) параллельно по строкам
+inline double chebyshev_update(const ParallelMatrix &A, const double *x, const double *F,
+                               double a, double b, double *r, double *d, double *x_next)
+{
+    ConstMatrixView M = A.view();
+    return A.sum_over_parts([=](int, int first, int last) {
+        return chebyshev_update_rows(M, first, last, x, F, a, b, r, d, x_next);
+    });
+}
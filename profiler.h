@@ -0,0 +1,409 @@
+#pragma once
+
+// Профилирование этапов решателя: интервалы по областям видимости
+// (PROFILE_SCOPE, PROFILE_ITERATION), счётчики операций и прочитанных
+// байтов (PROFILE_FLOPS, PROFILE_BYTES), значения по ходу счёта
+// (PROFILE_COUNTER) и, по желанию, аппаратные счётчики perf_event
+// (такты, инструкции, промахи кеша). События пишутся в буфер своего
+// потока под его собственным мьютексом (другие потоки его не берут, пока
+// идёт запись), а PROFILE_STOP забирает буферы, сохраняет события в
+// формате Chrome tracing (открывается в chrome://tracing и
+// ui.perfetto.dev) и печатает сводку по этапам. PROFILE_START и
+// PROFILE_STOP можно вызывать, пока потоки пула ещё работают: их события
+// попадут в ту запись, во время которой начался интервал, или будут
+// отброшены.
+// Включается флагом -DENABLE_PROFILING; без него макросы PROFILE_*
+// пусты, их аргументы не вычисляются, и код профилирования не попадает
+// в программу.
+
+#ifdef ENABLE_PROFILING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PROFILER_PERF_EVENTS
+#endif
+
+// Аппаратные счётчики текущего потока: группа perf_event из тактов,
+// инструкций и промахов последнего уровня кеша, читается одним read.
+// Если perf_event недоступен (не Linux, perf_event_paranoid, контейнер),
+// read возвращает false и события пишутся без них.
+class PerfCounters {
+public:
+    static const int COUNT = 3;
+
+    PerfCounters() : opened_(false) { std::fill(fd_, fd_ + COUNT, -1); }
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters() { close(); }
+
+    bool read(std::uint64_t *values)
+    {
+#ifdef PROFILER_PERF_EVENTS
+        if (!opened_) open();
+        if (fd_[0] < 0) return false;
+        struct {
+            std::uint64_t nr;
+            std::uint64_t values[COUNT];
+        } group;
+        if (::read(fd_[0], &group, sizeof(group)) != ssize_t(sizeof(group)) || group.nr != COUNT) return false;
+        std::copy(group.values, group.values + COUNT, values);
+        return true;
+#else
+        (void)values;
+        return false;
+#endif
+    }
+
+private:
+    void open()
+    {
+        opened_ = true;
+#ifdef PROFILER_PERF_EVENTS
+        const std::uint64_t configs[COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+        for (int k = 0; k < COUNT; k++) {
+            perf_event_attr attr = {};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[k];
+            attr.read_format = PERF_FORMAT_GROUP;
+            attr.disabled = k == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd_[k] = int(syscall(SYS_perf_event_open, &attr, 0, -1, k ? fd_[0] : -1, 0));
+            if (fd_[k] < 0) {
+                close();
+                return;
+            }
+        }
+        ioctl(fd_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fd_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    void close()
+    {
+#ifdef PROFILER_PERF_EVENTS
+        for (int k = COUNT - 1; k >= 0; k--) {
+            if (fd_[k] >= 0) ::close(fd_[k]);
+        }
+#endif
+        std::fill(fd_, fd_ + COUNT, -1);
+    }
+
+    bool opened_;
+    int fd_[COUNT];
+};
+
+// Событие трассы: интервал ('X') или значение счётчика ('C')
+struct ProfileEvent {
+    const char *name;
+    char phase;
+    // Номер итерации, -1 - не итерация
+    int iteration;
+    // Начало и длительность в микросекундах от PROFILE_START; для 'C' - value
+    double begin;
+    double duration;
+    double value;
+    double flops;
+    double bytes;
+    bool hardware;
+    std::uint64_t counters[PerfCounters::COUNT];
+};
+
+// Буфер событий одного потока и накопленные в нём счётчики операций.
+// flops, bytes и perf использует только поток-владелец; events читает
+// и stop() из другого потока, поэтому обращения к events идут под mutex.
+// generation - номер записи, к которой относятся events: буфер прошлой
+// записи очищает сам владелец при первом событии новой.
+struct ProfileThread {
+    int id = 0;
+    double flops = 0;
+    double bytes = 0;
+    std::mutex mutex;
+    int generation = 0;
+    std::vector<ProfileEvent> events;
+    PerfCounters perf;
+};
+
+class Profiler {
+public:
+    Profiler() : enabled_(false), hardware_(false), generation_(0),
+                 origin_(std::chrono::steady_clock::now().time_since_epoch().count()) {}
+
+    // Начало новой записи. Буферы потоков здесь не трогаются: события
+    // прошлой записи отбрасываются по её номеру (см. record)
+    void start(const std::string& trace_file, bool hardware_counters = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trace_file_ = trace_file;
+        hardware_.store(hardware_counters, std::memory_order_relaxed);
+        origin_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        generation_.fetch_add(1, std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_release);
+    }
+
+    // Конец записи: буферы потоков забираются, трасса пишется в файл из
+    // start, сводка - в out. События, которые потоки допишут позже, в эту
+    // запись уже не попадут.
+    void stop(std::ostream& out = std::cerr)
+    {
+        enabled_.store(false, std::memory_order_release);
+        Snapshot snapshot = take_events();
+        if (!write_trace(trace_file_, snapshot)) std::cerr << "Error when try to open file" << std::endl;
+        print_summary(out, snapshot);
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+    bool hardware_counters() const { return hardware_.load(std::memory_order_relaxed); }
+    int generation() const { return generation_.load(std::memory_order_relaxed); }
+
+    double now() const
+    {
+        std::chrono::steady_clock::duration since(std::chrono::steady_clock::now().time_since_epoch().count() -
+                                                  origin_.load(std::memory_order_relaxed));
+        return std::chrono::duration<double, std::micro>(since).count();
+    }
+
+    // Буфер вызывающего потока; регистрируется при первом обращении и
+    // живёт до конца программы, даже если поток (например, пула) завершился
+    ProfileThread& thread()
+    {
+        thread_local ProfileThread *current = nullptr;
+        if (!current) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.emplace_back(new ProfileThread());
+            current = threads_.back().get();
+            current->id = int(threads_.size());
+        }
+        return *current;
+    }
+
+    // Событие записи generation в буфер потока. Если запись уже сменилась
+    // (интервал начался до PROFILE_START), событие отбрасывается.
+    void record(ProfileThread& thread, const ProfileEvent& event, int generation)
+    {
+        std::lock_guard<std::mutex> lock(thread.mutex);
+        if (generation != generation_.load(std::memory_order_relaxed)) return;
+        if (thread.generation != generation) {
+            thread.events.clear();
+            thread.generation = generation;
+        }
+        thread.events.push_back(event);
+    }
+
+private:
+    // События записи по потокам: номер потока и его события
+    typedef std::vector<std::pair<int, std::vector<ProfileEvent>>> Snapshot;
+
+    // Забирает буферы текущей записи, оставляя потокам пустые
+    Snapshot take_events()
+    {
+        Snapshot snapshot;
+        std::lock_guard<std::mutex> lock(mutex_);
+        int generation = generation_.load(std::memory_order_relaxed);
+        for (const auto& thread : threads_) {
+            std::lock_guard<std::mutex> thread_lock(thread->mutex);
+            if (thread->generation != generation) continue;
+            snapshot.emplace_back(thread->id, std::vector<ProfileEvent>());
+            snapshot.back().second.swap(thread->events);
+        }
+        return snapshot;
+    }
+
+    // Трасса в формате Chrome tracing (JSON Object Format)
+    static bool write_trace(const std::string& filename, const Snapshot& snapshot)
+    {
+        std::FILE *file = std::fopen(filename.c_str(), "w");
+        if (!file) return false;
+        std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        const char *separator = "\n";
+        for (const auto& thread : snapshot) {
+            for (const ProfileEvent& e : thread.second) {
+                std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+                             separator, e.name, e.phase, thread.first, e.begin);
+                separator = ",\n";
+                if (e.phase == 'C') {
+                    std::fprintf(file, ",\"args\":{\"value\":%.9g}}", e.value);
+                    continue;
+                }
+                std::fprintf(file, ",\"dur\":%.3f,\"args\":{", e.duration);
+                const char *comma = "";
+                if (e.iteration >= 0) std::fprintf(file, "\"iteration\":%d", e.iteration), comma = ",";
+                if (e.flops > 0) {
+                    std::fprintf(file, "%s\"flops\":%.6g,\"GFLOP/s\":%.4g", comma, e.flops, e.duration > 0 ? e.flops / e.duration * 1e-3 : 0.0);
+                    comma = ",";
+                }
+                if (e.bytes > 0) {
+                    std::fprintf(file, "%s\"bytes\":%.6g,\"GB/s\":%.4g", comma, e.bytes, e.duration > 0 ? e.bytes / e.duration * 1e-3 : 0.0);
+                    comma = ",";
+                }
+                if (e.hardware) {
+                    std::fprintf(file, "%s\"cycles\":%llu,\"instructions\":%llu,\"IPC\":%.3g,\"cache_misses\":%llu", comma,
+                                 (unsigned long long)e.counters[0], (unsigned long long)e.counters[1],
+                                 e.counters[0] ? double(e.counters[1]) / e.counters[0] : 0.0, (unsigned long long)e.counters[2]);
+                }
+                std::fprintf(file, "}}");
+            }
+        }
+        std::fprintf(file, "\n]}\n");
+        return std::fclose(file) == 0;
+    }
+
+    // Сводка по этапам: число вызовов, суммарное время (вложенные этапы
+    // входят во время объемлющих), GFLOP/s, GB/s и IPC
+    static void print_summary(std::ostream& out, const Snapshot& snapshot)
+    {
+        struct Total {
+            int calls = 0;
+            double time = 0, flops = 0, bytes = 0, cycles = 0, instructions = 0;
+        };
+        std::map<std::string, Total> totals;
+        for (const auto& thread : snapshot) {
+            for (const ProfileEvent& e : thread.second) {
+                if (e.phase != 'X') continue;
+                Total& t = totals[e.name];
+                t.calls++, t.time += e.duration, t.flops += e.flops, t.bytes += e.bytes;
+                if (e.hardware) t.cycles += e.counters[0], t.instructions += e.counters[1];
+            }
+        }
+        out << std::left << std::setw(32) << "phase" << std::right << std::setw(8) << "calls" << std::setw(12) << "time, ms"
+            << std::setw(10) << "GFLOP/s" << std::setw(9) << "GB/s" << std::setw(7) << "IPC" << std::endl;
+        for (const auto& it : totals) {
+            const Total& t = it.second;
+            out << std::left << std::setw(32) << it.first << std::right << std::setw(8) << t.calls << std::fixed
+                << std::setprecision(3) << std::setw(12) << t.time * 1e-3 << std::setprecision(2)
+                << std::setw(10) << (t.time > 0 ? t.flops / t.time * 1e-3 : 0.0)
+                << std::setw(9) << (t.time > 0 ? t.bytes / t.time * 1e-3 : 0.0) << std::setw(7);
+            if (t.cycles > 0) out << t.instructions / t.cycles;
+            else out << "-";
+            out << std::defaultfloat << std::endl;
+        }
+    }
+
+    std::atomic<bool> enabled_;
+    std::atomic<bool> hardware_;
+    std::atomic<int> generation_;
+    // Начало записи в тиках steady_clock
+    std::atomic<std::chrono::steady_clock::rep> origin_;
+    std::string trace_file_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ProfileThread>> threads_;
+};
+
+inline Profiler& profiler()
+{
+    static Profiler instance;
+    return instance;
+}
+
+// Интервал от конструктора до деструктора. Операции и байты, учтённые в
+// этом потоке за время интервала (в том числе во вложенных), идут в его событие.
+// name должно жить до конца программы (строковый литерал).
+class ProfileScope {
+public:
+    explicit ProfileScope(const char *name, int iteration = -1) : thread_(nullptr), generation_(0)
+    {
+        Profiler& p = profiler();
+        if (!p.enabled()) return;
+        thread_ = &p.thread();
+        generation_ = p.generation();
+        event_.name = name;
+        event_.phase = 'X';
+        event_.iteration = iteration;
+        event_.value = 0;
+        event_.flops = thread_->flops;
+        event_.bytes = thread_->bytes;
+        event_.hardware = p.hardware_counters() && thread_->perf.read(event_.counters);
+        event_.begin = p.now();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ~ProfileScope()
+    {
+        if (!thread_) return;
+        event_.duration = profiler().now() - event_.begin;
+        event_.flops = thread_->flops - event_.flops;
+        event_.bytes = thread_->bytes - event_.bytes;
+        if (event_.hardware) {
+            std::uint64_t end[PerfCounters::COUNT];
+            event_.hardware = thread_->perf.read(end);
+            for (int k = 0; k < PerfCounters::COUNT; k++) event_.counters[k] = end[k] - event_.counters[k];
+        }
+        profiler().record(*thread_, event_, generation_);
+    }
+
+private:
+    ProfileThread *thread_;
+    // Запись, во время которой начался интервал
+    int generation_;
+    ProfileEvent event_;
+};
+
+inline void profile_add_flops(double flops)
+{
+    Profiler& p = profiler();
+    if (p.enabled()) p.thread().flops += flops;
+}
+
+inline void profile_add_bytes(double bytes)
+{
+    Profiler& p = profiler();
+    if (p.enabled()) p.thread().bytes += bytes;
+}
+
+inline void profile_counter(const char *name, double value)
+{
+    Profiler& p = profiler();
+    if (!p.enabled()) return;
+    ProfileEvent e = {};
+    e.name = name;
+    e.phase = 'C';
+    e.iteration = -1;
+    e.begin = p.now();
+    e.value = value;
+    p.record(p.thread(), e, p.generation());
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+// Запись в trace_file с аппаратными счётчиками или без; PROFILE_STOP
+// сохраняет трассу и печатает сводку в std::cerr
+#define PROFILE_START(trace_file, hardware_counters) profiler().start(trace_file, hardware_counters)
+#define PROFILE_STOP() profiler().stop()
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_ITERATION(name, iteration) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name, iteration)
+#define PROFILE_FLOPS(flops) profile_add_flops(flops)
+#define PROFILE_BYTES(bytes) profile_add_bytes(bytes)
+#define PROFILE_COUNTER(name, value) profile_counter(name, value)
+
+#else
+
+#define PROFILE_START(trace_file, hardware_counters) ((void)0)
+#define PROFILE_STOP() ((void)0)
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_ITERATION(name, iteration) ((void)0)
+#define PROFILE_FLOPS(flops) ((void)0)
+#define PROFILE_BYTES(bytes) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+
+#endif
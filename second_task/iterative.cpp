@@ -0,0 +1,783 @@
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+// Импорт кода из первого задания(прямого метода)
+#include "../lu.cpp"
+#include "preconditioners.cpp"
+
+// Перегрузки операторов
+template<typename T>
+std::ostream& 
+operator<<(std::ostream &out, const std::vector<T> &v)
+{
+    for (auto &it : v) out << it << " ";
+    return out;
+}
+
+// Произведение матриц блочным gemm из kernels.h (упаковка и микроядро
+// на регистрах); для проверки разложений вида L * U
+template<typename T>
+BasicMatrix<T>
+operator*(const BasicMatrix<T> &m1, const BasicMatrix<T> &m2)
+{
+    if (m1.cols() != m2.rows()) throw "Matrix sizes doesnt match";
+    BasicMatrix<T> res(m1.rows(), m2.cols());
+    gemm<T>(T(1), m1.view(), m2.view(), res.view());
+    return res;
+}
+
+// Умножение параллельно по строкам на пуле потоков матрицы
+std::vector<double>
+operator*(const ParallelMatrix &m, const std::vector<double> &x)
+{
+    if (m.cols() != int(x.size())) throw "Matrix and vector sizes doesnt match";
+    std::vector<double> ret(m.rows());
+    gemv(m, x.data(), ret.data());
+    return ret;
+}
+
+// Работа одного умножения на матрицу для счётчиков профилировщика:
+// умножения со сложениями и прочитанные байты матрицы
+template<typename MatrixType>
+double matvec_flops(const MatrixType &A) { return 2.0 * A.nnz(); }
+double matvec_flops(const Matrix &A) { return 2.0 * A.rows() * A.cols(); }
+double matvec_flops(const ParallelMatrix &A) { return 2.0 * A.rows() * A.cols(); }
+
+template<typename MatrixType>
+double matvec_bytes(const MatrixType &A) { return double(A.nnz()) * (sizeof(double) + sizeof(int)); }
+double matvec_bytes(const Matrix &A) { return double(A.rows()) * A.cols() * sizeof(double); }
+double matvec_bytes(const ParallelMatrix &A) { return double(A.rows()) * A.cols() * sizeof(double); }
+
+// функция для постороения множества тетта, которое используется для генерации 
+// последовательности оптимальных итерационных параметров
+std::vector<int>
+theta_set_construction(int m)
+{
+    if ((m & (m - 1)) != 0) throw "Argument m must be power of 2";
+    if (m == 1) return std::vector<int>{0, 1};
+    m = m / 2;
+    std::vector<int> smaller_set = theta_set_construction(m);
+    std::vector<int> ret(m * 2 + 1);
+    for (int i = 1; i <= m; ++i)
+    {
+        ret[2 * i] = 4 * m - smaller_set[i];
+        ret[2 * i - 1] = smaller_set[i];
+    }
+    return ret;
+}
+
+std::vector<double>
+optim_iterative_parameters_set(int n)
+{
+    if ((n & (n - 1)) != 0) throw "Argument n must be power of 2";
+    std::vector<double> ret(n + 1);
+    auto theta = theta_set_construction(n);
+    for (int i = 1; i <= n; ++i)
+    {
+        ret[i] = cos(M_PI * theta[i] / (n * 2));
+    }
+    return ret;
+}
+
+double
+norm2(const std::vector<double> &v1)
+{
+    return sqrt(dot(v1.data(), v1.data(), int(v1.size())));
+}
+
+// Функция для нахождения оценки собственных значений с помощью теоремы Гершгорина
+std::vector<double>
+eigenvalue_estimation(ConstMatrixView A)
+{
+    double lambdaMax = 0.0;
+    double lambdaMin = 0.0;
+    for (int i = 0; i < A.rows(); ++i)
+    {
+        double sum_abs_not_diag = 0.0;
+        for (int j = 0; j < A.cols(); ++j)
+        {
+            if (i != j) sum_abs_not_diag += std::fabs(A[i][j]);
+        }
+        if (i == 0 || A[i][i] - sum_abs_not_diag < lambdaMin) lambdaMin = A[i][i] - sum_abs_not_diag;
+        if (i == 0 || A[i][i] + sum_abs_not_diag > lambdaMax) lambdaMax = A[i][i] + sum_abs_not_diag;
+    }
+    return std::vector<double> {lambdaMin, lambdaMax};
+}
+
+// Оценка Гершгорина для разреженной матрицы в формате CSR
+std::vector<double>
+eigenvalue_estimation(const CSRMatrix &A)
+{
+    double lambdaMax = 0.0;
+    double lambdaMin = 0.0;
+    for (int i = 0; i < A.rows(); ++i)
+    {
+        double diag = 0.0, sum_abs_not_diag = 0.0;
+        for (int k = A.row_ptr()[i]; k < A.row_ptr()[i + 1]; ++k)
+        {
+            if (A.col_index()[k] == i) diag = A.values()[k];
+            else sum_abs_not_diag += std::fabs(A.values()[k]);
+        }
+        if (i == 0 || diag - sum_abs_not_diag < lambdaMin) lambdaMin = diag - sum_abs_not_diag;
+        if (i == 0 || diag + sum_abs_not_diag > lambdaMax) lambdaMax = diag + sum_abs_not_diag;
+    }
+    return std::vector<double> {lambdaMin, lambdaMax};
+}
+
+// Оценка Гершгорина для матрицы в формате SELL-C-sigma (нули дополнения
+// ничего не добавляют к суммам)
+std::vector<double>
+eigenvalue_estimation(const SellMatrix &A)
+{
+    std::vector<double> diag(A.rows(), 0.0), sum_abs_not_diag(A.rows(), 0.0);
+    for (int s = 0; s < A.slices(); ++s)
+    {
+        for (int l = 0; l < SELL_C && s * SELL_C + l < A.rows(); ++l)
+        {
+            int i = A.row_perm()[s * SELL_C + l];
+            for (int j = 0; j < A.slice_len()[s]; ++j)
+            {
+                int p = A.slice_ptr()[s] + j * SELL_C + l;
+                if (A.col_index()[p] == i) diag[i] += A.values()[p];
+                else sum_abs_not_diag[i] += std::fabs(A.values()[p]);
+            }
+        }
+    }
+    double lambdaMax = 0.0;
+    double lambdaMin = 0.0;
+    for (int i = 0; i < A.rows(); ++i)
+    {
+        if (i == 0 || diag[i] - sum_abs_not_diag[i] < lambdaMin) lambdaMin = diag[i] - sum_abs_not_diag[i];
+        if (i == 0 || diag[i] + sum_abs_not_diag[i] > lambdaMax) lambdaMax = diag[i] + sum_abs_not_diag[i];
+    }
+    return std::vector<double> {lambdaMin, lambdaMax};
+}
+
+std::vector<double>
+eigenvalue_estimation(const ParallelMatrix &A)
+{
+    return eigenvalue_estimation(A.view());
+}
+
+bool
+is_symmetric(const ParallelMatrix &A, double tolerance = 0.0)
+{
+    return is_symmetric(A.view(), tolerance);
+}
+
+// Бюджет метода Ланцоша: число умножений матрицы на вектор
+const int LANCZOS_MAX_STEPS = 40;
+// Требуемая относительная точность границ спектра
+const double LANCZOS_TOLERANCE = 1e-3;
+// Запас, на который границы расширяются (доля ширины оценённого спектра)
+const double LANCZOS_SAFETY_MARGIN = 0.05;
+
+// Симметричная трёхдиагональная матрица T размера k задаётся диагональю
+// alpha[0..k-1] и поддиагональю beta[0..k-2]; сама T не строится.
+
+// Число собственных значений T, меньших x (число отрицательных элементов
+// последовательности Штурма q_i = alpha_i - x - beta_{i-1}^2 / q_{i-1})
+int
+sturm_count(const std::vector<double> &alpha, const std::vector<double> &beta, int k, double x)
+{
+    const double pivmin = std::numeric_limits<double>::min();
+    int count = 0;
+    double q = 1.0;
+    for (int i = 0; i < k; ++i)
+    {
+        q = alpha[i] - x - (i > 0 ? beta[i - 1] * beta[i - 1] / q : 0.0);
+        if (std::fabs(q) < pivmin) q = -pivmin;
+        if (q < 0) ++count;
+    }
+    return count;
+}
+
+// Собственное значение T с номером index (по возрастанию) бисекцией по
+// числу Штурма на отрезке Гершгорина: O(k) на шаг, ~50 шагов до
+// машинной точности
+double
+tridiagonal_eigenvalue(const std::vector<double> &alpha, const std::vector<double> &beta, int k, int index)
+{
+    double lo = alpha[0], hi = alpha[0];
+    for (int i = 0; i < k; ++i)
+    {
+        double radius = (i > 0 ? std::fabs(beta[i - 1]) : 0.0) + (i + 1 < k ? std::fabs(beta[i]) : 0.0);
+        lo = std::min(lo, alpha[i] - radius);
+        hi = std::max(hi, alpha[i] + radius);
+    }
+    const double eps = std::numeric_limits<double>::epsilon();
+    while (hi - lo > 2 * eps * std::max(std::fabs(lo), std::fabs(hi)))
+    {
+        double mid = 0.5 * (lo + hi);
+        if (mid <= lo || mid >= hi) break;
+        if (sturm_count(alpha, beta, k, mid) > index) hi = mid;
+        else lo = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+// Последняя компонента нормированного собственного вектора T для
+// собственного значения lambda обратной итерацией: два решения системы
+// (T - lambda I) y = y методом Гаусса с выбором главного элемента по
+// столбцу (как dgtsv из LAPACK), нулевые ведущие элементы заменяются
+// малыми. O(k).
+double
+eigenvector_last_component(const std::vector<double> &alpha, const std::vector<double> &beta, int k, double lambda)
+{
+    // Малый ведущий элемент - относительно нормы T, а не T - lambda I:
+    // последняя может быть нулевой (например, при k = 1)
+    double scale = 0.0;
+    for (int i = 0; i < k; ++i) scale = std::max(scale, std::fabs(alpha[i]) + (i + 1 < k ? std::fabs(beta[i]) : 0.0));
+    const double pivmin = std::max(std::numeric_limits<double>::epsilon() * scale, std::numeric_limits<double>::min());
+
+    // Детерминированный начальный вектор, как в lanczos_eigenvalue_estimation
+    std::vector<double> y(k), d(k), du(k, 0.0), du2(k, 0.0), dl(k, 0.0);
+    for (int i = 0; i < k; ++i) y[i] = 1.0 + 0.5 * sin(1.0 + i);
+    for (int step = 0; step < 2; ++step)
+    {
+        for (int i = 0; i < k; ++i)
+        {
+            d[i] = alpha[i] - lambda;
+            du[i] = dl[i] = i + 1 < k ? beta[i] : 0.0;
+            du2[i] = 0.0;
+        }
+        for (int i = 0; i + 1 < k; ++i)
+        {
+            if (std::fabs(d[i]) >= std::fabs(dl[i]))
+            {
+                if (d[i] == 0.0) d[i] = pivmin;
+                double f = dl[i] / d[i];
+                d[i + 1] -= f * du[i];
+                y[i + 1] -= f * y[i];
+            }
+            else
+            {
+                // Перестановка строк i и i + 1
+                double f = d[i] / dl[i];
+                d[i] = dl[i];
+                double t = d[i + 1];
+                d[i + 1] = du[i] - f * t;
+                if (i + 2 < k)
+                {
+                    du2[i] = du[i + 1];
+                    du[i + 1] = -f * du2[i];
+                }
+                du[i] = t;
+                std::swap(y[i], y[i + 1]);
+                y[i + 1] -= f * y[i];
+            }
+        }
+        if (d[k - 1] == 0.0) d[k - 1] = pivmin;
+        for (int i = k - 1; i >= 0; --i)
+        {
+            double sum = y[i];
+            if (i + 1 < k) sum -= du[i] * y[i + 1];
+            if (i + 2 < k) sum -= du2[i] * y[i + 2];
+            y[i] = sum / d[i];
+        }
+        // Сначала делим на наибольшую компоненту, чтобы квадраты не переполнились
+        double largest = 0.0;
+        for (double item : y) largest = std::max(largest, std::fabs(item));
+        for (auto &item : y) item /= largest;
+        double norm = norm2(y);
+        for (auto &item : y) item /= norm;
+    }
+    return y[k - 1];
+}
+
+// Оценка границ спектра симметричной матрицы методом Ланцоша.
+// За k шагов строится трёхдиагональная матрица T_k, её крайние
+// собственные значения (числа Ритца) быстро сходятся к крайним
+// собственным значениям A. Числа Ритца лежат внутри спектра, поэтому
+// границы расширяются на оценку погрешности beta_k * |s_k| (s_k -
+// последняя компонента собственного вектора T_k). Крайние числа Ритца
+// ищутся бисекцией по Штурму, s_k - обратной итерацией прямо по
+// коэффициентам alpha, beta: проверка стоит O(k) на шаг бисекции, и время
+// оценки определяется умножениями на матрицу. Запас - не меньше чем на
+// LANCZOS_SAFETY_MARGIN ширины спектра: при близких собственных значениях
+// число Ритца может сойтись не к крайнему из них, а заниженная верхняя
+// граница приводит к расходимости метода Чебышева. Нижняя граница при
+// положительном наименьшем числе Ритца не опускается ниже его половины
+// (как в preconditioned_eigenvalue_estimation): иначе при обусловленности
+// больше ~20 запас по ширине спектра уводит её в ноль, и метод Чебышева
+// перестаёт сходиться. Результат пересекается с оценкой Гершгорина.
+// Останавливается, когда погрешность обеих границ меньше tolerance
+// (относительно), или после maxSteps умножений на матрицу.
+// Для несимметричной матрицы возвращает оценку Гершгорина.
+// Здесь и ниже MatrixType - Matrix, CSRMatrix или SellMatrix: от матрицы
+// нужны только rows(), cols(), gemv и residual.
+template<typename MatrixType>
+std::vector<double>
+lanczos_eigenvalue_estimation(const MatrixType &A, int maxSteps = LANCZOS_MAX_STEPS, double tolerance = LANCZOS_TOLERANCE)
+{
+    PROFILE_SCOPE("lanczos_eigenvalue_estimation");
+    std::vector<double> gershgorin = eigenvalue_estimation(A);
+    if (!is_symmetric(A)) return gershgorin;
+    int n = A.rows();
+    int m = std::min(maxSteps, n);
+    double lambdaMin = gershgorin[0], lambdaMax = gershgorin[1];
+
+    // Детерминированный начальный вектор, чтобы оценка не менялась от запуска к запуску
+    std::vector<double> v(n), vPrev(n, 0.0), w(n);
+    for (int i = 0; i < n; ++i) v[i] = 1.0 + 0.5 * sin(1.0 + i);
+    double norm = norm2(v);
+    for (auto &item : v) item /= norm;
+
+    std::vector<double> alpha, beta;
+    for (int j = 0; j < m; ++j)
+    {
+        gemv(A, v.data(), w.data());
+        double a = dot(w.data(), v.data(), n);
+        axpy(n, -a, v.data(), w.data());
+        if (j > 0) axpy(n, -beta[j - 1], vPrev.data(), w.data());
+        alpha.push_back(a);
+        double b = norm2(w);
+        bool last = (j + 1 == m) || b <= 1e-14 * std::fabs(a);
+
+        if (last || (j + 1) % 5 == 0)
+        {
+            int k = j + 1;
+            double ritzMin = tridiagonal_eigenvalue(alpha, beta, k, 0);
+            double ritzMax = tridiagonal_eigenvalue(alpha, beta, k, k - 1);
+            double errMin = b * std::fabs(eigenvector_last_component(alpha, beta, k, ritzMin));
+            double errMax = b * std::fabs(eigenvector_last_component(alpha, beta, k, ritzMax));
+            double margin = LANCZOS_SAFETY_MARGIN * (ritzMax - ritzMin);
+            double lower = ritzMin - std::max(errMin, margin);
+            if (ritzMin > 0) lower = std::max(lower, ritzMin / 2);
+            lambdaMin = std::max(gershgorin[0], lower);
+            lambdaMax = std::min(gershgorin[1], ritzMax + std::max(errMax, margin));
+            if (errMin <= tolerance * std::fabs(ritzMin) && errMax <= tolerance * std::fabs(ritzMax)) break;
+        }
+        if (last) break;
+
+        beta.push_back(b);
+        std::swap(vPrev, v);
+        for (int i = 0; i < n; ++i) v[i] = w[i] / b;
+    }
+    return std::vector<double> {lambdaMin, lambdaMax};
+}
+
+// Оценка границ спектра M^{-1} A для симметричных A и M (M - предобусловливатель).
+// Явно M^{-1} A не строится: коэффициенты alpha_j, beta_j метода
+// сопряжённых градиентов с предобусловливанием задают трёхдиагональную
+// матрицу Ланцоша для M^{-1} A:
+//   T[j][j] = 1 / alpha_j + beta_{j-1} / alpha_{j-1},
+//   T[j][j+1] = sqrt(beta_j) / alpha_j,
+// дальше - как в lanczos_eigenvalue_estimation. Нижняя граница не
+// опускается ниже половины наименьшего числа Ритца, а верхняя поднимается
+// хотя бы на tolerance от наибольшего: если M почти совпадает с A, спектр
+// стягивается в точку и метод Чебышева иначе делил бы на нулевую ширину.
+template<typename MatrixType>
+std::vector<double>
+preconditioned_eigenvalue_estimation(const MatrixType &A, const Preconditioner &M,
+                                     int maxSteps = LANCZOS_MAX_STEPS, double tolerance = LANCZOS_TOLERANCE)
+{
+    if (!is_symmetric(A)) throw "Preconditioned spectrum estimation requires symmetric matrix";
+    int n = A.rows();
+    int m = std::min(maxSteps, n);
+
+    // x0 = 0 и детерминированная правая часть, как в lanczos_eigenvalue_estimation
+    std::vector<double> r(n), z, p, q(n);
+    for (int i = 0; i < n; ++i) r[i] = 1.0 + 0.5 * sin(1.0 + i);
+    M.apply(r, z);
+    p = z;
+    double rz = dot(r.data(), z.data(), n);
+    double lambdaMin = 0.0, lambdaMax = 0.0;
+
+    // alpha, beta - коэффициенты предыдущего шага CG
+    double alpha = 0.0, beta = 0.0;
+    std::vector<double> diag, offDiag;
+    for (int j = 0; j < m; ++j)
+    {
+        gemv(A, p.data(), q.data());
+        double a = rz / dot(p.data(), q.data(), n);
+        axpy(n, -a, q.data(), r.data());
+        M.apply(r, z);
+        double rzNext = dot(r.data(), z.data(), n);
+        double b = rzNext / rz;
+        // Строка j матрицы T: диагональ и элемент под ней
+        diag.push_back(1.0 / a + (j > 0 ? beta / alpha : 0.0));
+        offDiag.push_back(sqrt(b) / a);
+        alpha = a, beta = b;
+        bool last = (j + 1 == m) || rzNext <= 1e-28 * rz;
+
+        if (last || (j + 1) % 5 == 0)
+        {
+            int k = j + 1;
+            double ritzMin = tridiagonal_eigenvalue(diag, offDiag, k, 0);
+            double ritzMax = tridiagonal_eigenvalue(diag, offDiag, k, k - 1);
+            double errMin = offDiag[j] * std::fabs(eigenvector_last_component(diag, offDiag, k, ritzMin));
+            double errMax = offDiag[j] * std::fabs(eigenvector_last_component(diag, offDiag, k, ritzMax));
+            double margin = LANCZOS_SAFETY_MARGIN * (ritzMax - ritzMin);
+            lambdaMin = std::max(ritzMin / 2, ritzMin - std::max(errMin, margin));
+            lambdaMax = ritzMax + std::max(std::max(errMax, margin), tolerance * ritzMax);
+            if (errMin <= tolerance * std::fabs(ritzMin) && errMax <= tolerance * std::fabs(ritzMax)) break;
+        }
+        if (last) break;
+
+        for (int i = 0; i < n; ++i) p[i] = z[i] + b * p[i];
+        rz = rzNext;
+    }
+    return std::vector<double> {lambdaMin, lambdaMax};
+}
+
+// Решение системы линейных уравнений методом Чебышева при известных
+// границах спектра [lambdaMin, lambdaMax].
+// Шаг x = xPrev + tau * (F - A xPrev) делается одним проходом по строкам
+// (chebyshev_update): матрица читается один раз за итерацию, а попутно
+// получается невязка xPrev, т.е. невязка после предыдущей итерации - она
+// и идёт в статистику. В statX/statY записываются номер итерации и вторая
+// норма невязки после неё для каждой statStride-й итерации и для
+// последней; statStride = 0 - статистика не собирается. Для
+// ParallelMatrix проход идёт параллельно по строкам.
+template<typename MatrixType>
+std::vector<double> chebyshevIteration(const MatrixType& A,
+                                       const std::vector<double>& F,
+                                       std::vector<float> &statX,
+                                       std::vector<float> &statY,
+                                       int maxIterations,
+                                       double lambdaMin,
+                                       double lambdaMax,
+                                       int statStride = 1)
+{
+    PROFILE_SCOPE("chebyshevIteration");
+    if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+    if ((maxIterations & (maxIterations - 1)) != 0) throw "maxIterations argument should be power of 2";
+    statX.clear(), statY.clear();
+    if (statStride > 0) statX.reserve(maxIterations / statStride + 1), statY.reserve(maxIterations / statStride + 1);
+    int n = A.rows();
+    std::vector<double> x(n, 0.0), xNext(n);
+    std::vector<double> r(n), d(n, 0.0);
+
+    double tau0 = 2.0 / (lambdaMax + lambdaMin);
+    double ro = (lambdaMax - lambdaMin) / (lambdaMax + lambdaMin);
+
+    std::vector<double> tau_parameters = optim_iterative_parameters_set(maxIterations);
+    auto record = [&](int k, double norm) {
+        if (statStride > 0 && ((k + 1) % statStride == 0 || k + 1 == maxIterations)) {
+            statX.push_back(k);
+            statY.push_back(norm);
+        }
+    };
+    for (int k = 0; k < maxIterations; ++k) {
+        PROFILE_ITERATION("chebyshev iteration", k);
+        PROFILE_FLOPS(matvec_flops(A) + 6.0 * n);
+        PROFILE_BYTES(matvec_bytes(A));
+        double tau = tau0 / (1 - tau_parameters[k + 1] * ro);
+        // x = x + tau * (F - A * x); norm - невязка x до шага
+        double norm = sqrt(chebyshev_update(A, x.data(), F.data(), 0.0, tau, r.data(), d.data(), xNext.data()));
+        PROFILE_COUNTER("residual", norm);
+        std::swap(x, xNext);
+        if (k > 0) record(k - 1, norm);
+    }
+    // Невязку итогового приближения приходится считать отдельно
+    if (statStride > 0 && maxIterations > 0) {
+        residual(A, x.data(), F.data(), r.data());
+        record(maxIterations - 1, norm2(r));
+    }
+
+    return x;
+}
+
+// Решение системы линейных уравнений методом Чебышева; границы спектра
+// оцениваются методом Ланцоша
+template<typename MatrixType>
+std::vector<double> chebyshevIteration(const MatrixType& A,
+                                       const std::vector<double>& F,
+                                       std::vector<float> &statX,
+                                       std::vector<float> &statY,
+                                       int maxIterations,
+                                       int statStride = 1)
+{
+    std::vector<double> estim = lanczos_eigenvalue_estimation(A);
+    return chebyshevIteration(A, F, statX, statY, maxIterations, estim[0], estim[1], statStride);
+}
+
+// Метод Чебышева с трёхчленной рекуррентной формулой (Саад, "Iterative
+// Methods for Sparse Linear Systems", алгоритм 12.1). В отличие от
+// chebyshevIteration не требует заранее заданного числа итераций вида 2^m
+// и набора параметров optim_iterative_parameters_set: каждая итерация
+// даёт оптимальное для своего номера приближение, поэтому решатель можно
+// останавливать по невязке и продолжать с того же места, не теряя
+// сделанной работы. Невязка F - A x пересчитывается по x на каждой
+// итерации (одно умножение на матрицу), а не накапливается рекуррентно.
+// Без предобусловливателя итерация - один проход chebyshev_update:
+// невязка, новая поправка d и следующее приближение xNext = x + d
+// считаются вместе, и матрица читается один раз.
+// С предобусловливателем M итерации строятся для M^{-1} A x = M^{-1} F:
+// в поправку d вместо невязки r идёт z = M^{-1} r, а [lambdaMin, lambdaMax]
+// - границы спектра M^{-1} A (см. preconditioned_eigenvalue_estimation).
+// Начальное приближение x0 (по умолчанию нулевое) можно задать.
+// Границы должны удовлетворять 0 < lambdaMin <= lambdaMax, иначе бросается
+// исключение (для несимметричной A оценка Гершгорина может их нарушить).
+// Решатель хранит ссылку на A и указатель на M: они должны жить дольше
+// решателя. Правая часть F копируется и может быть временной.
+template<typename MatrixType>
+class ChebyshevSolver
+{
+public:
+    ChebyshevSolver(const MatrixType &A, const std::vector<double> &F, double lambdaMin, double lambdaMax,
+                    const Preconditioner *preconditioner = nullptr, const std::vector<double> *x0 = nullptr)
+        : A_(A), F_(F), M_(preconditioner), x_(A.rows(), 0.0), xNext_(A.rows()), r_(F), d_(A.rows()), iterations_(0)
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        if (int(F.size()) != A.rows()) throw "Matrix and vector sizes doesnt match";
+        if (x0 && int(x0->size()) != A.rows()) throw "Matrix and vector sizes doesnt match";
+        // Совпавшие границы (оценка спектра c * I) раздвигаются на точность
+        // оценки: при нулевой ширине спектра delta параметры не определены
+        if (lambdaMin > 0 && lambdaMax == lambdaMin) lambdaMax = lambdaMin * (1 + LANCZOS_TOLERANCE);
+        if (!(0 < lambdaMin && lambdaMin < lambdaMax)) throw "Chebyshev method requires 0 < lambdaMin <= lambdaMax";
+        theta_ = (lambdaMax + lambdaMin) / 2;
+        delta_ = (lambdaMax - lambdaMin) / 2;
+        sigma_ = theta_ / delta_;
+        rho_ = 1 / sigma_;
+        // r0 = F - A x0, d0 = M^{-1} r0 / theta
+        if (x0)
+        {
+            x_ = *x0;
+            residual(A_, x_.data(), F_.data(), r_.data());
+        }
+        const std::vector<double> &z = precondition();
+        for (int i = 0; i < A.rows(); ++i) d_[i] = z[i] / theta_, xNext_[i] = x_[i] + d_[i];
+        normF_ = norm2(F);
+        residualNorm_ = norm2(r_);
+    }
+
+    // Продолжает итерации с текущего приближения, пока
+    // ||F - A x|| > tolerance * ||F|| и сделано меньше maxIterations новых
+    // итераций. В statX/statY (если переданы) дописываются номер итерации
+    // и норма невязки после каждой statStride-й итерации.
+    // Возвращает true, если точность достигнута.
+    bool iterate(double tolerance, int maxIterations,
+                 std::vector<float> *statX = nullptr, std::vector<float> *statY = nullptr, int statStride = 1)
+    {
+        int n = A_.rows();
+        for (int k = 0; k < maxIterations && residualNorm_ > tolerance * normF_; ++k)
+        {
+            PROFILE_ITERATION("chebyshev iteration", iterations_);
+            PROFILE_FLOPS(matvec_flops(A_) + 6.0 * n);
+            PROFILE_BYTES(matvec_bytes(A_));
+            // x = x + d уже посчитано на прошлой итерации
+            std::swap(x_, xNext_);
+            ++iterations_;
+
+            // d = scale * d + 2 * rhoNext / delta * M^{-1} (F - A x), xNext = x + d
+            double rhoNext = 1 / (2 * sigma_ - rho_);
+            double scale = rhoNext * rho_;
+            if (!M_)
+            {
+                residualNorm_ = sqrt(chebyshev_update(A_, x_.data(), F_.data(), scale, 2 * rhoNext / delta_,
+                                                      r_.data(), d_.data(), xNext_.data()));
+            }
+            else
+            {
+                residual(A_, x_.data(), F_.data(), r_.data());
+                residualNorm_ = norm2(r_);
+                for (int i = 0; i < n; ++i) d_[i] *= scale;
+                axpy(n, 2 * rhoNext / delta_, precondition().data(), d_.data());
+                vector_add(n, x_.data(), d_.data(), xNext_.data());
+            }
+            rho_ = rhoNext;
+            PROFILE_COUNTER("residual", residualNorm_);
+
+            if (statX && statY && statStride > 0 && iterations_ % statStride == 0)
+            {
+                statX->push_back(iterations_ - 1);
+                statY->push_back(residualNorm_);
+            }
+        }
+        return residualNorm_ <= tolerance * normF_;
+    }
+
+    const std::vector<double> &solution() const { return x_; }
+    int iterations() const { return iterations_; }
+    double residual_norm() const { return residualNorm_; }
+
+private:
+    // z = M^{-1} r (без предобусловливателя - сама невязка)
+    const std::vector<double> &precondition()
+    {
+        if (!M_) return r_;
+        M_->apply(r_, z_);
+        return z_;
+    }
+
+    const MatrixType &A_;
+    std::vector<double> F_;
+    const Preconditioner *M_;
+    std::vector<double> x_;
+    // Следующее приближение x + d
+    std::vector<double> xNext_;
+    std::vector<double> r_;
+    std::vector<double> z_;
+    std::vector<double> d_;
+    double theta_, delta_, sigma_, rho_;
+    double normF_, residualNorm_;
+    int iterations_;
+};
+
+// Параметры итерационных решателей с общим интерфейсом
+struct IterativeOptions
+{
+    // Останов, когда ||F - A x|| <= tolerance * ||F||
+    double tolerance = 1e-10;
+    int maxIterations = 1000;
+    // nullptr - без предобусловливания
+    const Preconditioner *preconditioner = nullptr;
+    // Если задан, сюда дописывается вторая норма невязки после каждой итерации
+    std::vector<double> *residualHistory = nullptr;
+};
+
+struct IterativeResult
+{
+    bool converged;
+    int iterations;
+    // Норма невязки после последней итерации (в CG и BiCGSTAB невязка
+    // обновляется рекуррентно и может немного отличаться от F - A x)
+    double residualNorm;
+};
+
+// Общая сигнатура итерационного решателя: x - начальное приближение
+// на входе и решение на выходе
+template<typename MatrixType>
+using BasicIterativeMethod = IterativeResult (*)(const MatrixType &A, const std::vector<double> &F,
+                                                 std::vector<double> &x, const IterativeOptions &options);
+typedef BasicIterativeMethod<Matrix> IterativeMethod;
+
+// Метод сопряжённых градиентов с предобусловливанием (PCG) для
+// симметричной положительно определённой A и симметричного M.
+// Одно умножение на матрицу и одно применение M на итерацию.
+template<typename MatrixType>
+IterativeResult
+conjugate_gradient(const MatrixType &A, const std::vector<double> &F, std::vector<double> &x, const IterativeOptions &options)
+{
+    if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+    int n = A.rows();
+    if (int(F.size()) != n || int(x.size()) != n) throw "Matrix and vector sizes doesnt match";
+    const Preconditioner *M = options.preconditioner;
+
+    std::vector<double> r(n), z, p, q(n);
+    residual(A, x.data(), F.data(), r.data());
+    if (M) M->apply(r, z);
+    else z = r;
+    p = z;
+    double rz = dot(r.data(), z.data(), n);
+    double normF = norm2(F);
+    IterativeResult result = {false, 0, norm2(r)};
+
+    while (result.residualNorm > options.tolerance * normF && result.iterations < options.maxIterations)
+    {
+        PROFILE_ITERATION("cg iteration", result.iterations);
+        PROFILE_FLOPS(matvec_flops(A) + 10.0 * n);
+        PROFILE_BYTES(matvec_bytes(A));
+        gemv(A, p.data(), q.data());
+        double pq = dot(p.data(), q.data(), n);
+        if (pq == 0.0) break;
+        double alpha = rz / pq;
+        axpy(n, alpha, p.data(), x.data());
+        axpy(n, -alpha, q.data(), r.data());
+        result.residualNorm = norm2(r);
+        ++result.iterations;
+        if (options.residualHistory) options.residualHistory->push_back(result.residualNorm);
+        PROFILE_COUNTER("residual", result.residualNorm);
+
+        if (M) M->apply(r, z);
+        else z = r;
+        double rzNext = dot(r.data(), z.data(), n);
+        double beta = rzNext / rz;
+        for (int i = 0; i < n; ++i) p[i] = z[i] + beta * p[i];
+        rz = rzNext;
+    }
+    result.converged = result.residualNorm <= options.tolerance * normF;
+    return result;
+}
+
+// Стабилизированный метод бисопряжённых градиентов (BiCGSTAB, ван дер Ворст)
+// с правым предобусловливанием: A M^{-1} y = F, x = M^{-1} y. Годится для
+// несимметричных матриц; на итерацию - два умножения на матрицу и два
+// применения M. При вырождении (rho = 0 или omega = 0) останавливается.
+template<typename MatrixType>
+IterativeResult
+bicgstab(const MatrixType &A, const std::vector<double> &F, std::vector<double> &x, const IterativeOptions &options)
+{
+    if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+    int n = A.rows();
+    if (int(F.size()) != n || int(x.size()) != n) throw "Matrix and vector sizes doesnt match";
+    const Preconditioner *M = options.preconditioner;
+
+    std::vector<double> r(n), rHat, p(n, 0.0), v(n, 0.0), s(n), t(n), pHat, sHat;
+    residual(A, x.data(), F.data(), r.data());
+    rHat = r;
+    double rho = 1.0, alpha = 1.0, omega = 1.0;
+    double normF = norm2(F);
+    IterativeResult result = {false, 0, norm2(r)};
+
+    while (result.residualNorm > options.tolerance * normF && result.iterations < options.maxIterations)
+    {
+        PROFILE_ITERATION("bicgstab iteration", result.iterations);
+        PROFILE_FLOPS(2 * matvec_flops(A) + 20.0 * n);
+        PROFILE_BYTES(2 * matvec_bytes(A));
+        double rhoNext = dot(rHat.data(), r.data(), n);
+        if (rhoNext == 0.0) break;
+        double beta = (rhoNext / rho) * (alpha / omega);
+        for (int i = 0; i < n; ++i) p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        if (M) M->apply(p, pHat);
+        else pHat = p;
+        gemv(A, pHat.data(), v.data());
+        alpha = rhoNext / dot(rHat.data(), v.data(), n);
+        for (int i = 0; i < n; ++i) s[i] = r[i] - alpha * v[i];
+        rho = rhoNext;
+        ++result.iterations;
+
+        double normS = norm2(s);
+        if (normS <= options.tolerance * normF)
+        {
+            axpy(n, alpha, pHat.data(), x.data());
+            r = s;
+            result.residualNorm = normS;
+            if (options.residualHistory) options.residualHistory->push_back(result.residualNorm);
+            PROFILE_COUNTER("residual", result.residualNorm);
+            break;
+        }
+
+        if (M) M->apply(s, sHat);
+        else sHat = s;
+        gemv(A, sHat.data(), t.data());
+        double tt = dot(t.data(), t.data(), n);
+        omega = tt == 0.0 ? 0.0 : dot(t.data(), s.data(), n) / tt;
+        axpy(n, alpha, pHat.data(), x.data());
+        axpy(n, omega, sHat.data(), x.data());
+        for (int i = 0; i < n; ++i) r[i] = s[i] - omega * t[i];
+        result.residualNorm = norm2(r);
+        if (options.residualHistory) options.residualHistory->push_back(result.residualNorm);
+        PROFILE_COUNTER("residual", result.residualNorm);
+        if (omega == 0.0) break;
+    }
+    result.converged = result.residualNorm <= options.tolerance * normF;
+    return result;
+}
+
+// Метод Чебышева (ChebyshevSolver) в общем интерфейсе. Границы спектра
+// оцениваются методом Ланцоша, с предобусловливателем - по коэффициентам
+// PCG (preconditioned_eigenvalue_estimation); их оценка входит во время
+// решения, но не в число итераций.
+template<typename MatrixType>
+IterativeResult
+chebyshev_solve(const MatrixType &A, const std::vector<double> &F, std::vector<double> &x, const IterativeOptions &options)
+{
+    std::vector<double> spectrum = options.preconditioner
+        ? preconditioned_eigenvalue_estimation(A, *options.preconditioner)
+        : lanczos_eigenvalue_estimation(A);
+    ChebyshevSolver solver(A, F, spectrum[0], spectrum[1], options.preconditioner, &x);
+    bool converged = solver.iterate(options.tolerance, 0);
+    while (!converged && solver.iterations() < options.maxIterations)
+    {
+        converged = solver.iterate(options.tolerance, 1);
+        if (options.residualHistory) options.residualHistory->push_back(solver.residual_norm());
+    }
+    x = solver.solution();
+    return IterativeResult {converged, solver.iterations(), solver.residual_norm()};
+}
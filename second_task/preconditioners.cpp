@@ -0,0 +1,317 @@
+#include <vector>
+#include <cmath>
+
+// Предобусловливатели для итерационных методов. Каждый строится по
+// матрице системы один раз и затем применяется на каждой итерации:
+// z = M^{-1} r, где M - приближение к A, систему с которым решить дёшево.
+class Preconditioner
+{
+public:
+    virtual ~Preconditioner() {}
+    // z = M^{-1} r (z не должен совпадать с r)
+    virtual void apply(const std::vector<double> &r, std::vector<double> &z) const = 0;
+    virtual const char *name() const = 0;
+};
+
+// Предобусловливатель Якоби: M = diag(A)
+class JacobiPreconditioner : public Preconditioner
+{
+public:
+    explicit JacobiPreconditioner(ConstMatrixView A) : inverseDiag_(A.rows())
+    {
+        for (int i = 0; i < A.rows(); ++i)
+        {
+            if (A[i][i] == 0.0) throw "Zero diagonal element in Jacobi preconditioner";
+            inverseDiag_[i] = 1.0 / A[i][i];
+        }
+    }
+
+    explicit JacobiPreconditioner(const CSRMatrix &A) : inverseDiag_(A.diagonal())
+    {
+        for (auto &d : inverseDiag_)
+        {
+            if (d == 0.0) throw "Zero diagonal element in Jacobi preconditioner";
+            d = 1.0 / d;
+        }
+    }
+
+    void apply(const std::vector<double> &r, std::vector<double> &z) const override
+    {
+        z.resize(r.size());
+        for (int i = 0; i < int(r.size()); ++i) z[i] = inverseDiag_[i] * r[i];
+    }
+
+    const char *name() const override { return "Jacobi"; }
+
+private:
+    std::vector<double> inverseDiag_;
+};
+
+// Размер диагонального блока блочного предобусловливателя Якоби по умолчанию
+const int BLOCK_JACOBI_SIZE = 16;
+
+// Блочный предобусловливатель Якоби: M - блочная диагональ A с блоками
+// blockSize x blockSize; каждый блок заранее раскладывается в LU.
+class BlockJacobiPreconditioner : public Preconditioner
+{
+public:
+    BlockJacobiPreconditioner(ConstMatrixView A, int blockSize = BLOCK_JACOBI_SIZE) : blockSize_(blockSize)
+    {
+        if (blockSize < 1) throw "Block size should be positive";
+        int n = A.rows();
+        for (int i0 = 0; i0 < n; i0 += blockSize)
+        {
+            int b = std::min(blockSize, n - i0);
+            blocks_.emplace_back(A.block(i0, i0, b, b));
+        }
+    }
+
+    // Для разреженной матрицы блоки собираются в плотные матрицы b x b
+    BlockJacobiPreconditioner(const CSRMatrix &A, int blockSize = BLOCK_JACOBI_SIZE) : blockSize_(blockSize)
+    {
+        if (blockSize < 1) throw "Block size should be positive";
+        int n = A.rows();
+        for (int i0 = 0; i0 < n; i0 += blockSize)
+        {
+            int b = std::min(blockSize, n - i0);
+            Matrix block(b, b);
+            for (int i = 0; i < b; ++i)
+            {
+                for (int k = A.row_ptr()[i0 + i]; k < A.row_ptr()[i0 + i + 1]; ++k)
+                {
+                    int j = A.col_index()[k] - i0;
+                    if (j >= 0 && j < b) block[i][j] = A.values()[k];
+                }
+            }
+            blocks_.emplace_back(block);
+        }
+    }
+
+    void apply(const std::vector<double> &r, std::vector<double> &z) const override
+    {
+        z.resize(r.size());
+        // Подстановки напрямую, как в ILU(0): LUFactorization::solve - этап
+        // профилирования прямого решателя, а не предобусловливания
+        for (int k = 0; k < int(blocks_.size()); ++k)
+        {
+            const LUFactorization &block = blocks_[k];
+            int i0 = k * blockSize_, b = block.size();
+            work_.resize(b);
+            for (int i = 0; i < b; ++i) work_[i] = r[i0 + block.row_perm()[i]];
+            LU_substitute<double>(block.lu(), block.lu(), work_.data());
+            for (int i = 0; i < b; ++i) z[i0 + block.col_perm()[i]] = work_[i];
+        }
+    }
+
+    const char *name() const override { return "block Jacobi"; }
+
+private:
+    int blockSize_;
+    std::vector<LUFactorization> blocks_;
+    mutable std::vector<double> work_;
+};
+
+// Параметр релаксации SSOR по умолчанию
+const double SSOR_OMEGA = 1.0;
+
+// Симметричный метод последовательной верхней релаксации (SSOR):
+// M = w / (2 - w) * (D / w + L) (D / w)^{-1} (D / w + U),
+// где A = L + D + U. Применение - прямой и обратный ход Гаусса-Зейделя.
+// Для симметричной A предобусловливатель симметричен (годится для CG).
+// Хранит собственную копию A, так что исходная матрица может быть временной.
+class SSORPreconditioner : public Preconditioner
+{
+public:
+    SSORPreconditioner(ConstMatrixView A, double omega = SSOR_OMEGA) : A_(A.rows(), A.cols()), omega_(omega)
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        if (omega <= 0.0 || omega >= 2.0) throw "SSOR parameter omega should be in (0, 2)";
+        int n = A.rows();
+        for (int i = 0; i < n; ++i)
+        {
+            if (A[i][i] == 0.0) throw "Zero diagonal element in SSOR preconditioner";
+            std::copy(A[i], A[i] + n, A_[i]);
+        }
+    }
+
+    void apply(const std::vector<double> &r, std::vector<double> &z) const override
+    {
+        int n = A_.rows();
+        z.resize(n);
+        // (D / w + L) y = r
+        for (int i = 0; i < n; ++i)
+        {
+            const double *Ai = A_[i];
+            double sum = r[i];
+            for (int j = 0; j < i; ++j) sum -= Ai[j] * z[j];
+            z[i] = sum * omega_ / Ai[i];
+        }
+        // y := (2 - w) / w * (D / w) y
+        for (int i = 0; i < n; ++i) z[i] *= (2.0 - omega_) / omega_ * A_[i][i] / omega_;
+        // (D / w + U) z = y
+        for (int i = n - 1; i >= 0; --i)
+        {
+            const double *Ai = A_[i];
+            double sum = z[i];
+            for (int j = i + 1; j < n; ++j) sum -= Ai[j] * z[j];
+            z[i] = sum * omega_ / Ai[i];
+        }
+    }
+
+    const char *name() const override { return "SSOR"; }
+
+private:
+    Matrix A_;
+    double omega_;
+};
+
+// Неполное LU-разложение без заполнения ILU(0): множители L и U имеют тот
+// же портрет, что и A (элементы, равные нулю в A, остаются нулями).
+// Для плотной матрицы совпадает с полным LU-разложением без перестановок.
+class ILU0Preconditioner : public Preconditioner
+{
+public:
+    explicit ILU0Preconditioner(ConstMatrixView A) : lu_(A.rows(), A.cols())
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        int n = A.rows();
+        for (int i = 0; i < n; ++i) std::copy(A[i], A[i] + n, lu_[i]);
+        for (int i = 1; i < n; ++i)
+        {
+            double *Ri = lu_[i];
+            const double *Ai = A[i];
+            for (int k = 0; k < i; ++k)
+            {
+                if (Ai[k] == 0.0) continue;
+                if (lu_[k][k] == 0.0) throw "Zero pivot in ILU(0) preconditioner";
+                double lik = Ri[k] / lu_[k][k];
+                Ri[k] = lik;
+                const double *Rk = lu_[k];
+                for (int j = k + 1; j < n; ++j)
+                {
+                    if (Ai[j] != 0.0) Ri[j] -= lik * Rk[j];
+                }
+            }
+        }
+        if (n > 0 && lu_[n - 1][n - 1] == 0.0) throw "Zero pivot in ILU(0) preconditioner";
+    }
+
+    void apply(const std::vector<double> &r, std::vector<double> &z) const override
+    {
+        z = r;
+        LU_substitute<double>(lu_, lu_, z.data());
+    }
+
+    const char *name() const override { return "ILU(0)"; }
+
+private:
+    Matrix lu_;
+};
+
+// SSOR для разреженной матрицы в формате CSR (см. SSORPreconditioner):
+// прямой и обратный ход идут только по хранимым элементам строк.
+// Как и SparseILU0Preconditioner, хранит копию A.
+class SparseSSORPreconditioner : public Preconditioner
+{
+public:
+    SparseSSORPreconditioner(const CSRMatrix &A, double omega = SSOR_OMEGA) : A_(A), omega_(omega), diag_(A.rows())
+    {
+        if (omega <= 0.0 || omega >= 2.0) throw "SSOR parameter omega should be in (0, 2)";
+        for (int i = 0; i < A.rows(); ++i)
+        {
+            diag_[i] = A.find(i, i);
+            if (diag_[i] < 0 || A.values()[diag_[i]] == 0.0) throw "Zero diagonal element in SSOR preconditioner";
+        }
+    }
+
+    void apply(const std::vector<double> &r, std::vector<double> &z) const override
+    {
+        int n = A_.rows();
+        const int *rowPtr = A_.row_ptr().data();
+        const int *col = A_.col_index().data();
+        const double *val = A_.values().data();
+        z.resize(n);
+        // Столбцы в строке возрастают: элементы левее diag_[i] - это L, правее - U
+        for (int i = 0; i < n; ++i)
+        {
+            double sum = r[i];
+            for (int k = rowPtr[i]; k < diag_[i]; ++k) sum -= val[k] * z[col[k]];
+            z[i] = sum * omega_ / val[diag_[i]];
+        }
+        for (int i = 0; i < n; ++i) z[i] *= (2.0 - omega_) / omega_ * val[diag_[i]] / omega_;
+        for (int i = n - 1; i >= 0; --i)
+        {
+            double sum = z[i];
+            for (int k = diag_[i] + 1; k < rowPtr[i + 1]; ++k) sum -= val[k] * z[col[k]];
+            z[i] = sum * omega_ / val[diag_[i]];
+        }
+    }
+
+    const char *name() const override { return "SSOR"; }
+
+private:
+    CSRMatrix A_;
+    double omega_;
+    std::vector<int> diag_;
+};
+
+// ILU(0) для разреженной матрицы в формате CSR (Саад, "Iterative Methods
+// for Sparse Linear Systems", алгоритм 10.4). Множители хранятся на месте
+// копии A: L (единичная диагональ не хранится) и U с тем же портретом.
+class SparseILU0Preconditioner : public Preconditioner
+{
+public:
+    explicit SparseILU0Preconditioner(const CSRMatrix &A) : lu_(A), diag_(A.rows())
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        int n = A.rows();
+        const int *rowPtr = lu_.row_ptr().data();
+        const int *col = lu_.col_index().data();
+        std::vector<double> &val = lu_.values();
+        // position[j] - позиция элемента (i, j) текущей строки или -1
+        std::vector<int> position(n, -1);
+        for (int i = 0; i < n; ++i)
+        {
+            for (int k = rowPtr[i]; k < rowPtr[i + 1]; ++k) position[col[k]] = k;
+            for (int k = rowPtr[i]; k < rowPtr[i + 1] && col[k] < i; ++k)
+            {
+                int c = col[k];
+                val[k] /= val[diag_[c]];
+                for (int m = diag_[c] + 1; m < rowPtr[c + 1]; ++m)
+                {
+                    if (position[col[m]] >= 0) val[position[col[m]]] -= val[k] * val[m];
+                }
+            }
+            diag_[i] = position[i];
+            if (diag_[i] < 0 || val[diag_[i]] == 0.0) throw "Zero pivot in ILU(0) preconditioner";
+            for (int k = rowPtr[i]; k < rowPtr[i + 1]; ++k) position[col[k]] = -1;
+        }
+    }
+
+    void apply(const std::vector<double> &r, std::vector<double> &z) const override
+    {
+        int n = lu_.rows();
+        const int *rowPtr = lu_.row_ptr().data();
+        const int *col = lu_.col_index().data();
+        const double *val = lu_.values().data();
+        z.resize(n);
+        for (int i = 0; i < n; ++i)
+        {
+            double sum = r[i];
+            for (int k = rowPtr[i]; k < diag_[i]; ++k) sum -= val[k] * z[col[k]];
+            z[i] = sum;
+        }
+        for (int i = n - 1; i >= 0; --i)
+        {
+            double sum = z[i];
+            for (int k = diag_[i] + 1; k < rowPtr[i + 1]; ++k) sum -= val[k] * z[col[k]];
+            z[i] = sum / val[diag_[i]];
+        }
+    }
+
+    const char *name() const override { return "ILU(0)"; }
+
+private:
+    CSRMatrix lu_;
+    std::vector<int> diag_;
+};
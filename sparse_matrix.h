@@ -0,0 +1,545 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "matrix.h"
+#include "vector_ops.h"
+
+// Разреженные матрицы. Хранятся только ненулевые элементы, поэтому
+// умножение на вектор (SpMV) стоит O(nnz), а не O(n^2).
+//   CSR (compressed sparse row) - элементы по строкам: строка i занимает
+//     позиции [row_ptr[i], row_ptr[i + 1]) массивов col_index и values,
+//     столбцы внутри строки возрастают.
+//   CSC (compressed sparse column) - то же по столбцам (CSR транспонированной).
+//   SELL-C-sigma - строки группируются по C в срезы, внутри среза элементы
+//     хранятся по столбцам, так что C строк обрабатываются одной векторной
+//     инструкцией (см. SellMatrix).
+
+template<typename T>
+class BasicCSRMatrix
+{
+public:
+    BasicCSRMatrix() : rows_(0), cols_(0), row_ptr_(1, 0) {}
+
+    // Проверяет структуру: размеры массивов, возрастание row_ptr и
+    // строго возрастающие столбцы внутри каждой строки
+    BasicCSRMatrix(int rows, int cols, std::vector<int> row_ptr, std::vector<int> col_index, std::vector<T> values)
+        : rows_(rows), cols_(cols), row_ptr_(std::move(row_ptr)), col_index_(std::move(col_index)), values_(std::move(values))
+    {
+        if (rows < 0 || cols < 0 || int(row_ptr_.size()) != rows + 1 || row_ptr_[0] != 0 ||
+            row_ptr_[rows] != int(col_index_.size()) || col_index_.size() != values_.size()) {
+            throw "Incorrect CSR structure";
+        }
+        for (int i = 0; i < rows; ++i) {
+            if (row_ptr_[i] > row_ptr_[i + 1]) throw "Incorrect CSR structure";
+            for (int k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) {
+                int j = col_index_[k];
+                if (j < 0 || j >= cols || (k > row_ptr_[i] && j <= col_index_[k - 1])) throw "Incorrect CSR structure";
+            }
+        }
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int nnz() const { return int(values_.size()); }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+    const std::vector<int> &row_ptr() const { return row_ptr_; }
+    const std::vector<int> &col_index() const { return col_index_; }
+    const std::vector<T> &values() const { return values_; }
+    // Значения можно менять, портрет матрицы - нет
+    std::vector<T> &values() { return values_; }
+
+    // Позиция элемента (i, j) в values или -1, если он не хранится
+    int find(int i, int j) const
+    {
+        const int *begin = col_index_.data() + row_ptr_[i];
+        const int *end = col_index_.data() + row_ptr_[i + 1];
+        const int *p = std::lower_bound(begin, end, j);
+        return (p != end && *p == j) ? int(p - col_index_.data()) : -1;
+    }
+
+    T operator()(int i, int j) const
+    {
+        int k = find(i, j);
+        return k < 0 ? T() : values_[k];
+    }
+
+    std::vector<T> diagonal() const
+    {
+        std::vector<T> d(std::min(rows_, cols_), T());
+        for (int i = 0; i < int(d.size()); ++i) d[i] = (*this)(i, i);
+        return d;
+    }
+
+private:
+    int rows_;
+    int cols_;
+    std::vector<int> row_ptr_;
+    std::vector<int> col_index_;
+    std::vector<T> values_;
+};
+
+typedef BasicCSRMatrix<double> CSRMatrix;
+
+// CSR из плотной матрицы; отбрасываются элементы с |a_ij| <= drop_tolerance
+// (по умолчанию - только нули)
+template<typename T>
+BasicCSRMatrix<T> csr_from_dense(BasicMatrixView<const T> A, T drop_tolerance = T())
+{
+    std::vector<int> row_ptr(A.rows() + 1, 0), col_index;
+    std::vector<T> values;
+    for (int i = 0; i < A.rows(); ++i) {
+        const T *row = A[i];
+        for (int j = 0; j < A.cols(); ++j) {
+            if (std::fabs(row[j]) > drop_tolerance) {
+                col_index.push_back(j);
+                values.push_back(row[j]);
+            }
+        }
+        row_ptr[i + 1] = int(values.size());
+    }
+    return BasicCSRMatrix<T>(A.rows(), A.cols(), std::move(row_ptr), std::move(col_index), std::move(values));
+}
+
+template<typename T>
+BasicCSRMatrix<T> csr_from_dense(const BasicMatrix<T> &A, T drop_tolerance = T())
+{
+    return csr_from_dense<T>(A.view(), drop_tolerance);
+}
+
+// CSR из троек (i, j, a_ij) в произвольном порядке; повторяющиеся
+// элементы складываются
+template<typename T>
+BasicCSRMatrix<T> csr_from_triplets(int rows, int cols, const std::vector<int> &I, const std::vector<int> &J,
+                                    const std::vector<T> &V)
+{
+    if (I.size() != J.size() || I.size() != V.size()) throw "Triplet arrays sizes doesnt match";
+    // Сортировка подсчётом по строкам
+    std::vector<int> row_ptr(rows + 1, 0);
+    for (int i : I) {
+        if (i < 0 || i >= rows) throw "Matrix index out of range";
+        ++row_ptr[i + 1];
+    }
+    for (int i = 0; i < rows; ++i) row_ptr[i + 1] += row_ptr[i];
+    std::vector<int> next(row_ptr.begin(), row_ptr.end() - 1), order(I.size());
+    for (int k = 0; k < int(I.size()); ++k) order[next[I[k]]++] = k;
+
+    // Внутри строки - по столбцам, с объединением повторов
+    std::vector<int> new_ptr(rows + 1, 0), col_index;
+    std::vector<T> values;
+    col_index.reserve(I.size());
+    values.reserve(I.size());
+    for (int i = 0; i < rows; ++i) {
+        std::sort(order.begin() + row_ptr[i], order.begin() + row_ptr[i + 1],
+                  [&J](int a, int b) { return J[a] < J[b]; });
+        for (int p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+            int k = order[p];
+            if (J[k] < 0 || J[k] >= cols) throw "Matrix index out of range";
+            if (int(col_index.size()) > new_ptr[i] && col_index.back() == J[k]) {
+                values.back() += V[k];
+            } else {
+                col_index.push_back(J[k]);
+                values.push_back(V[k]);
+            }
+        }
+        new_ptr[i + 1] = int(values.size());
+    }
+    return BasicCSRMatrix<T>(rows, cols, std::move(new_ptr), std::move(col_index), std::move(values));
+}
+
+// Транспонирование за O(nnz): строки результата собираются подсчётом
+template<typename T>
+BasicCSRMatrix<T> transpose(const BasicCSRMatrix<T> &A)
+{
+    std::vector<int> row_ptr(A.cols() + 1, 0), col_index(A.nnz());
+    std::vector<T> values(A.nnz());
+    for (int j : A.col_index()) ++row_ptr[j + 1];
+    for (int j = 0; j < A.cols(); ++j) row_ptr[j + 1] += row_ptr[j];
+    std::vector<int> next(row_ptr.begin(), row_ptr.end() - 1);
+    for (int i = 0; i < A.rows(); ++i) {
+        for (int k = A.row_ptr()[i]; k < A.row_ptr()[i + 1]; ++k) {
+            int p = next[A.col_index()[k]]++;
+            col_index[p] = i;
+            values[p] = A.values()[k];
+        }
+    }
+    return BasicCSRMatrix<T>(A.cols(), A.rows(), std::move(row_ptr), std::move(col_index), std::move(values));
+}
+
+template<typename T>
+BasicMatrix<T> to_dense(const BasicCSRMatrix<T> &A)
+{
+    BasicMatrix<T> D(A.rows(), A.cols());
+    for (int i = 0; i < A.rows(); ++i) {
+        for (int k = A.row_ptr()[i]; k < A.row_ptr()[i + 1]; ++k) D[i][A.col_index()[k]] = A.values()[k];
+    }
+    return D;
+}
+
+// Проверка симметричности: |a_ij - a_ji| <= tolerance * max(|a_ij|, |a_ji|),
+// отсутствующий элемент считается нулём
+template<typename T>
+bool is_symmetric(const BasicCSRMatrix<T> &A, double tolerance = 0.0)
+{
+    if (A.rows() != A.cols()) return false;
+    for (int i = 0; i < A.rows(); ++i) {
+        for (int k = A.row_ptr()[i]; k < A.row_ptr()[i + 1]; ++k) {
+            double aij = A.values()[k], aji = A(A.col_index()[k], i);
+            if (std::fabs(aij - aji) > tolerance * std::max(std::fabs(aij), std::fabs(aji))) return false;
+        }
+    }
+    return true;
+}
+
+// Матрица в формате CSC. Хранит те же массивы, что CSR транспонированной
+// матрицы; удобна, когда матрицу нужно обходить по столбцам.
+template<typename T>
+class BasicCSCMatrix
+{
+public:
+    BasicCSCMatrix() {}
+    explicit BasicCSCMatrix(const BasicCSRMatrix<T> &A) : transposed_(transpose(A)) {}
+
+    int rows() const { return transposed_.cols(); }
+    int cols() const { return transposed_.rows(); }
+    int nnz() const { return transposed_.nnz(); }
+    bool empty() const { return transposed_.empty(); }
+
+    const std::vector<int> &col_ptr() const { return transposed_.row_ptr(); }
+    const std::vector<int> &row_index() const { return transposed_.col_index(); }
+    const std::vector<T> &values() const { return transposed_.values(); }
+
+    T operator()(int i, int j) const { return transposed_(j, i); }
+
+    BasicCSRMatrix<T> to_csr() const { return transpose(transposed_); }
+
+private:
+    BasicCSRMatrix<T> transposed_;
+};
+
+typedef BasicCSCMatrix<double> CSCMatrix;
+
+// Число строк в срезе SELL-C-sigma: 8 double - один регистр AVX-512
+const int SELL_C = 8;
+// Окно сортировки строк по длине (в строках)
+const int SELL_SIGMA = 256;
+
+namespace sparse_detail
+{
+
+// y = A x (f == nullptr) или y = f - A x для строк CSR [0, rows)
+inline void csr_gemv_scalar(int rows, const int *row_ptr, const int *col, const double *val,
+                            const double *x, const double *f, double *y)
+{
+    for (int i = 0; i < rows; ++i) {
+        double s0 = 0, s1 = 0;
+        int k = row_ptr[i], end = row_ptr[i + 1];
+        for (; k + 2 <= end; k += 2) {
+            s0 += val[k] * x[col[k]];
+            s1 += val[k + 1] * x[col[k + 1]];
+        }
+        if (k < end) s0 += val[k] * x[col[k]];
+        y[i] = f ? f[i] - (s0 + s1) : s0 + s1;
+    }
+}
+
+// y[l] = sum_j v[j * C + l] * x[c[j * C + l]], l < SELL_C - один срез SELL
+inline void sell_slice_scalar(const double *v, const int *c, int len, const double *x, double *y)
+{
+    double acc[SELL_C] = {};
+    for (int j = 0; j < len; ++j) {
+        for (int l = 0; l < SELL_C; ++l) acc[l] += v[j * SELL_C + l] * x[c[j * SELL_C + l]];
+    }
+    for (int l = 0; l < SELL_C; ++l) y[l] = acc[l];
+}
+
+#ifdef VECTOR_OPS_X86
+
+// Короткие строки (типичные 3-7 элементов) считаются скалярно: gather на
+// них не окупается, векторный путь включается только для длинных строк
+__attribute__((target("avx2,fma"))) inline void csr_gemv_avx2(int rows, const int *row_ptr, const int *col, const double *val,
+                                                             const double *x, const double *f, double *y)
+{
+    for (int i = 0; i < rows; ++i) {
+        int k = row_ptr[i], end = row_ptr[i + 1];
+        double sum = 0;
+        if (end - k >= 8) {
+            __m256d s = _mm256_setzero_pd();
+            for (; k + 4 <= end; k += 4) {
+                __m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(col + k));
+                s = _mm256_fmadd_pd(_mm256_loadu_pd(val + k), _mm256_i32gather_pd(x, idx, 8), s);
+            }
+            __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+            sum = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+        }
+        double s1 = 0;
+        for (; k + 2 <= end; k += 2) {
+            sum += val[k] * x[col[k]];
+            s1 += val[k + 1] * x[col[k + 1]];
+        }
+        if (k < end) sum += val[k] * x[col[k]];
+        y[i] = f ? f[i] - (sum + s1) : sum + s1;
+    }
+}
+
+__attribute__((target("avx2,fma"))) inline void sell_slice_avx2(const double *v, const int *c, int len, const double *x, double *y)
+{
+    __m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+    for (int j = 0; j < len; ++j) {
+        const int *cj = c + j * SELL_C;
+        const double *vj = v + j * SELL_C;
+        lo = _mm256_fmadd_pd(_mm256_loadu_pd(vj), _mm256_i32gather_pd(x, _mm_loadu_si128(reinterpret_cast<const __m128i *>(cj)), 8), lo);
+        hi = _mm256_fmadd_pd(_mm256_loadu_pd(vj + 4), _mm256_i32gather_pd(x, _mm_loadu_si128(reinterpret_cast<const __m128i *>(cj + 4)), 8), hi);
+    }
+    _mm256_storeu_pd(y, lo);
+    _mm256_storeu_pd(y + 4, hi);
+}
+
+__attribute__((target("avx512f"))) inline void csr_gemv_avx512(int rows, const int *row_ptr, const int *col, const double *val,
+                                                              const double *x, const double *f, double *y)
+{
+    for (int i = 0; i < rows; ++i) {
+        int k = row_ptr[i], end = row_ptr[i + 1];
+        double sum = 0;
+        if (end - k >= 16) {
+            __m512d s = _mm512_setzero_pd();
+            for (; k + 8 <= end; k += 8) {
+                __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(col + k));
+                s = _mm512_fmadd_pd(_mm512_loadu_pd(val + k), _mm512_i32gather_pd(idx, x, 8), s);
+            }
+            sum = _mm512_reduce_add_pd(s);
+        }
+        double s1 = 0;
+        for (; k + 2 <= end; k += 2) {
+            sum += val[k] * x[col[k]];
+            s1 += val[k + 1] * x[col[k + 1]];
+        }
+        if (k < end) sum += val[k] * x[col[k]];
+        y[i] = f ? f[i] - (sum + s1) : sum + s1;
+    }
+}
+
+__attribute__((target("avx512f"))) inline void sell_slice_avx512(const double *v, const int *c, int len, const double *x, double *y)
+{
+    __m512d acc = _mm512_setzero_pd();
+    for (int j = 0; j < len; ++j) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c + j * SELL_C));
+        acc = _mm512_fmadd_pd(_mm512_loadu_pd(v + j * SELL_C), _mm512_i32gather_pd(idx, x, 8), acc);
+    }
+    _mm512_storeu_pd(y, acc);
+}
+
+#endif
+
+} // namespace sparse_detail
+
+// Таблица ядер SpMV, выбранных под текущий процессор (как VectorKernels)
+struct SparseKernels
+{
+    const char *name;
+    void (*csr_gemv)(int rows, const int *row_ptr, const int *col, const double *val,
+                     const double *x, const double *f, double *y);
+    void (*sell_slice)(const double *v, const int *c, int len, const double *x, double *y);
+};
+
+inline SparseKernels select_sparse_kernels()
+{
+    using namespace sparse_detail;
+#ifdef VECTOR_OPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SparseKernels{"avx512", csr_gemv_avx512, sell_slice_avx512};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SparseKernels{"avx2", csr_gemv_avx2, sell_slice_avx2};
+    }
+#endif
+    return SparseKernels{"scalar", csr_gemv_scalar, sell_slice_scalar};
+}
+
+inline const SparseKernels &sparse_kernels()
+{
+    static const SparseKernels kernels = select_sparse_kernels();
+    return kernels;
+}
+
+// y = A x для CSR
+inline void gemv(const CSRMatrix &A, const double *x, double *y)
+{
+    sparse_kernels().csr_gemv(A.rows(), A.row_ptr().data(), A.col_index().data(), A.values().data(), x, nullptr, y);
+}
+
+// Невязка r = f - A x для CSR (r не должен совпадать с x)
+inline void residual(const CSRMatrix &A, const double *x, const double *f, double *r)
+{
+    sparse_kernels().csr_gemv(A.rows(), A.row_ptr().data(), A.col_index().data(), A.values().data(), x, f, r);
+}
+
+// y = A x для CSC: столбец j разносится по строкам с весом x[j]
+inline void gemv(const CSCMatrix &A, const double *x, double *y)
+{
+    std::fill(y, y + A.rows(), 0.0);
+    for (int j = 0; j < A.cols(); ++j) {
+        for (int k = A.col_ptr()[j]; k < A.col_ptr()[j + 1]; ++k) y[A.row_index()[k]] += A.values()[k] * x[j];
+    }
+}
+
+// Обобщённый вариант для других типов элементов
+template<typename T>
+void gemv(const BasicCSRMatrix<T> &A, const T *x, T *y)
+{
+    for (int i = 0; i < A.rows(); ++i) {
+        T sum = 0;
+        for (int k = A.row_ptr()[i]; k < A.row_ptr()[i + 1]; ++k) sum += A.values()[k] * x[A.col_index()[k]];
+        y[i] = sum;
+    }
+}
+
+// Формат SELL-C-sigma (Kreutzer и др., 2014). Строки внутри окон по sigma
+// строк сортируются по убыванию числа ненулевых элементов, затем
+// разбиваются на срезы по SELL_C строк. Срез хранится по столбцам:
+// элемент j строки l среза лежит в позиции slice_ptr[s] + j * SELL_C + l,
+// короткие строки дополняются нулями до длины самой длинной строки среза.
+// Одна итерация по j умножает сразу SELL_C строк (одна векторная загрузка
+// значений и одна gather-загрузка x), а сортировка уменьшает долю
+// дополнения. Результат пишется в исходном порядке строк.
+class SellMatrix
+{
+public:
+    SellMatrix() : rows_(0), cols_(0), nnz_(0), sigma_(SELL_SIGMA), symmetric_(false) {}
+
+    explicit SellMatrix(const CSRMatrix &A, int sigma = SELL_SIGMA)
+        : rows_(A.rows()), cols_(A.cols()), nnz_(A.nnz()), sigma_(sigma), symmetric_(is_symmetric(A))
+    {
+        if (sigma < 1) throw "SELL sigma should be positive";
+        const std::vector<int> &row_ptr = A.row_ptr();
+        auto length = [&row_ptr](int i) { return row_ptr[i + 1] - row_ptr[i]; };
+
+        perm_.resize(rows_);
+        for (int i = 0; i < rows_; ++i) perm_[i] = i;
+        for (int i0 = 0; i0 < rows_; i0 += sigma) {
+            std::stable_sort(perm_.begin() + i0, perm_.begin() + std::min(rows_, i0 + sigma),
+                             [&length](int a, int b) { return length(a) > length(b); });
+        }
+
+        int slices = (rows_ + SELL_C - 1) / SELL_C;
+        slice_ptr_.assign(slices + 1, 0);
+        slice_len_.assign(slices, 0);
+        for (int s = 0; s < slices; ++s) {
+            for (int l = 0; l < SELL_C && s * SELL_C + l < rows_; ++l) {
+                slice_len_[s] = std::max(slice_len_[s], length(perm_[s * SELL_C + l]));
+            }
+            slice_ptr_[s + 1] = slice_ptr_[s] + slice_len_[s] * SELL_C;
+        }
+        values_.assign(slice_ptr_[slices], 0.0);
+        col_index_.assign(slice_ptr_[slices], 0);
+        for (int s = 0; s < slices; ++s) {
+            for (int l = 0; l < SELL_C && s * SELL_C + l < rows_; ++l) {
+                int i = perm_[s * SELL_C + l];
+                int len = length(i);
+                for (int j = 0; j < slice_len_[s]; ++j) {
+                    int p = slice_ptr_[s] + j * SELL_C + l;
+                    // Дополнение ссылается на последний столбец строки, чтобы
+                    // gather не выходил за уже загруженные строки кэша x
+                    if (j < len) {
+                        values_[p] = A.values()[row_ptr[i] + j];
+                        col_index_[p] = A.col_index()[row_ptr[i] + j];
+                    } else if (len > 0) {
+                        col_index_[p] = A.col_index()[row_ptr[i] + len - 1];
+                    }
+                }
+            }
+        }
+    }
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    // Число ненулевых элементов исходной матрицы (без дополнения)
+    int nnz() const { return nnz_; }
+    // Число хранимых элементов с дополнением; nnz() / stored() - заполненность
+    int stored() const { return int(values_.size()); }
+    int sigma() const { return sigma_; }
+    int slices() const { return int(slice_len_.size()); }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+    // Симметричность исходной матрицы (проверяется при построении)
+    bool symmetric() const { return symmetric_; }
+
+    const std::vector<int> &row_perm() const { return perm_; }
+    const std::vector<int> &slice_ptr() const { return slice_ptr_; }
+    const std::vector<int> &slice_len() const { return slice_len_; }
+    const std::vector<int> &col_index() const { return col_index_; }
+    const std::vector<double> &values() const { return values_; }
+
+private:
+    int rows_;
+    int cols_;
+    int nnz_;
+    int sigma_;
+    bool symmetric_;
+    std::vector<int> perm_;
+    std::vector<int> slice_ptr_;
+    std::vector<int> slice_len_;
+    std::vector<int> col_index_;
+    std::vector<double> values_;
+};
+
+// y = A x для SELL-C-sigma
+inline void gemv(const SellMatrix &A, const double *x, double *y)
+{
+    const SparseKernels &k = sparse_kernels();
+    double slice[SELL_C];
+    for (int s = 0; s < A.slices(); ++s) {
+        int p = A.slice_ptr()[s];
+        k.sell_slice(A.values().data() + p, A.col_index().data() + p, A.slice_len()[s], x, slice);
+        for (int l = 0; l < SELL_C && s * SELL_C + l < A.rows(); ++l) y[A.row_perm()[s * SELL_C + l]] = slice[l];
+    }
+}
+
+// Невязка r = f - A x для SELL-C-sigma (r не должен совпадать с x)
+inline void residual(const SellMatrix &A, const double *x, const double *f, double *r)
+{
+    const SparseKernels &k = sparse_kernels();
+    double slice[SELL_C];
+    for (int s = 0; s < A.slices(); ++s) {
+        int p = A.slice_ptr()[s];
+        k.sell_slice(A.values().data() + p, A.col_index().data() + p, A.slice_len()[s], x, slice);
+        for (int l = 0; l < SELL_C && s * SELL_C + l < A.rows(); ++l) {
+            int i = A.row_perm()[s * SELL_C + l];
+            r[i] = f[i] - slice[l];
+        }
+    }
+}
+
+// Проверка симметричности с тем же критерием, что для CSR. Точная проверка
+// выполнена при построении; с допуском элементы сравниваются по SELL-массивам.
+inline bool is_symmetric(const SellMatrix &A, double tolerance = 0.0)
+{
+    if (tolerance == 0.0) return A.symmetric();
+    if (A.rows() != A.cols()) return false;
+    std::vector<int> position(A.rows());
+    for (int q = 0; q < A.rows(); ++q) position[A.row_perm()[q]] = q;
+    // a_ij - сумма по хранимым элементам строки: дополнение повторяет
+    // последний столбец строки с нулевым значением
+    auto at = [&A, &position](int i, int j) {
+        int s = position[i] / SELL_C, p = A.slice_ptr()[s] + position[i] % SELL_C;
+        double sum = 0.0;
+        for (int t = 0; t < A.slice_len()[s]; ++t, p += SELL_C) {
+            if (A.col_index()[p] == j) sum += A.values()[p];
+        }
+        return sum;
+    };
+    for (int i = 0; i < A.rows(); ++i) {
+        int s = position[i] / SELL_C, p = A.slice_ptr()[s] + position[i] % SELL_C;
+        for (int t = 0; t < A.slice_len()[s]; ++t, p += SELL_C) {
+            int j = A.col_index()[p];
+            double aij = at(i, j), aji = at(j, i);
+            if (std::fabs(aij - aji) > tolerance * std::max(std::fabs(aij), std::fabs(aji))) return false;
+        }
+    }
+    return true;
+}
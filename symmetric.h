@@ -0,0 +1,365 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "matrix.h"
+#include "kernels.h"
+#include "profiler.h"
+#include "vector_ops.h"
+
+// Разложения симметричных матриц с хранением одного нижнего треугольника:
+// блочное разложение Холецкого A = L L^T для положительно определённых
+// матриц и LDL^T с выбором ведущего элемента по Банчу - Кауфману для
+// знаконеопределённых. Оба требуют вдвое меньше операций и памяти, чем LU.
+
+// Ширина панели: плитки SYMMETRIC_TILE_SIZE x SYMMETRIC_TILE_SIZE
+// подаются в gemm целиком
+const int SYMMETRIC_TILE_SIZE = 128;
+
+// Нижний треугольник симметричной матрицы n x n по панелям столбцов
+// ширины SYMMETRIC_TILE_SIZE: панель J - строки [J * tile, n) столбцов
+// [J * tile, (J + 1) * tile), лежит непрерывно со страйдом tile, поэтому
+// её можно передать в gemm как обычный MatrixView. Памяти нужно около
+// n^2 / 2 чисел (плюс верхние половины диагональных плиток).
+class SymmetricMatrix
+{
+public:
+    SymmetricMatrix() : n_(0) {}
+
+    explicit SymmetricMatrix(int n) : n_(n), offset_(panels(n) + 1, 0)
+    {
+        for (int J = 0; J < panels(n); J++) offset_[J + 1] = offset_[J] + n - J * SYMMETRIC_TILE_SIZE;
+        data_ = Matrix(offset_.back(), SYMMETRIC_TILE_SIZE);
+    }
+
+    // Копия нижнего треугольника A (верхний не читается)
+    explicit SymmetricMatrix(ConstMatrixView A) : SymmetricMatrix(A.rows())
+    {
+        if (A.rows() != A.cols()) throw "Matrix should be n*n!\n";
+        for (int i = 0; i < n_; i++) {
+            for (int J = 0; J * SYMMETRIC_TILE_SIZE <= i; J++) {
+                int j0 = J * SYMMETRIC_TILE_SIZE, j1 = std::min(i + 1, j0 + SYMMETRIC_TILE_SIZE);
+                std::copy(A[i] + j0, A[i] + j1, row(i, J));
+            }
+        }
+    }
+
+    int size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+    int panels() const { return panels(n_); }
+    // Занимаемая память, байт
+    std::size_t memory() const { return std::size_t(data_.rows()) * data_.stride() * sizeof(double); }
+
+    // Панель J: (n - J * tile) x ширина, первая плитка - диагональная
+    MatrixView panel(int J)
+    {
+        int j0 = J * SYMMETRIC_TILE_SIZE;
+        return data_.view().block(offset_[J], 0, n_ - j0, std::min(SYMMETRIC_TILE_SIZE, n_ - j0));
+    }
+
+    ConstMatrixView panel(int J) const
+    {
+        int j0 = J * SYMMETRIC_TILE_SIZE;
+        return data_.view().block(offset_[J], 0, n_ - j0, std::min(SYMMETRIC_TILE_SIZE, n_ - j0));
+    }
+
+    // Элемент (i, J * tile) строки i в панели J (i >= J * tile)
+    double *row(int i, int J) { return data_[offset_[J] + i - J * SYMMETRIC_TILE_SIZE]; }
+    const double *row(int i, int J) const { return data_[offset_[J] + i - J * SYMMETRIC_TILE_SIZE]; }
+
+    // Элемент (i, j); для i < j возвращается симметричный (j, i)
+    double &operator()(int i, int j)
+    {
+        if (i < j) std::swap(i, j);
+        int J = j / SYMMETRIC_TILE_SIZE;
+        return row(i, J)[j - J * SYMMETRIC_TILE_SIZE];
+    }
+
+    double operator()(int i, int j) const
+    {
+        if (i < j) std::swap(i, j);
+        int J = j / SYMMETRIC_TILE_SIZE;
+        return row(i, J)[j - J * SYMMETRIC_TILE_SIZE];
+    }
+
+private:
+    static int panels(int n) { return (n + SYMMETRIC_TILE_SIZE - 1) / SYMMETRIC_TILE_SIZE; }
+
+    int n_;
+    std::vector<int> offset_;
+    Matrix data_;
+};
+
+// Неблочное разложение Холецкого диагональной плитки на месте
+// (нижний треугольник). false, если ведущий элемент не положителен.
+inline bool cholesky_factor_tile(MatrixView D)
+{
+    const VectorKernels &k = vector_kernels();
+    int n = D.rows();
+    for (int j = 0; j < n; j++) {
+        double *Dj = D[j];
+        double d = Dj[j] - k.dot(Dj, Dj, j);
+        if (!(d > 0)) return false;
+        Dj[j] = std::sqrt(d);
+        for (int i = j + 1; i < n; i++) {
+            double *Di = D[i];
+            Di[j] = (Di[j] - k.dot(Di, Dj, j)) / Dj[j];
+        }
+    }
+    return true;
+}
+
+// Блочное правостороннее разложение Холецкого A = L L^T на месте. На шаге
+// K раскладывается диагональная плитка, столбец панели под ней решается
+// L21 = A21 L11^{-T}, а остальные панели обновляются A22 -= L21 L21^T
+// ядром gemm (по одному вызову на панель). Возвращает false, если
+// матрица не положительно определена; A тогда испорчена.
+inline bool cholesky_factor(SymmetricMatrix &A)
+{
+    PROFILE_SCOPE("cholesky_factor");
+    PROFILE_FLOPS(double(A.size()) * A.size() * A.size() / 3);
+    const int tile = SYMMETRIC_TILE_SIZE;
+    // L21^T: строки - столбцы панели, чтобы trsm шёл длинными axpy
+    Matrix Wt;
+    for (int K = 0; K < A.panels(); K++) {
+        MatrixView P = A.panel(K);
+        int kb = P.cols(), rest = P.rows() - kb;
+        if (!cholesky_factor_tile(P.block(0, 0, kb, kb))) return false;
+        if (rest == 0) break;
+        Wt = Matrix::uninitialized(kb, rest);
+        for (int i = 0; i < rest; i++) {
+            const double *Pi = P[kb + i];
+            for (int j = 0; j < kb; j++) Wt[j][i] = Pi[j];
+        }
+        // Wt = L11^{-1} Wt
+        for (int j = 0; j < kb; j++) {
+            const double *Lj = P[j];
+            for (int p = 0; p < j; p++) axpy(rest, -Lj[p], Wt[p], Wt[j]);
+            double inv = 1.0 / Lj[j];
+            for (int i = 0; i < rest; i++) Wt[j][i] *= inv;
+        }
+        for (int i = 0; i < rest; i++) {
+            double *Pi = P[kb + i];
+            for (int j = 0; j < kb; j++) Pi[j] = Wt[j][i];
+        }
+        for (int J = K + 1; J < A.panels(); J++) {
+            MatrixView C = A.panel(J);
+            int offset = (J - K) * tile;
+            gemm(-1.0, ConstMatrixView(P.block(offset, 0, C.rows(), kb)),
+                 ConstMatrixView(Wt.view().block(0, offset - kb, kb, C.cols())), C);
+        }
+    }
+    return true;
+}
+
+// Решение L L^T x = b на месте
+inline void cholesky_solve(const SymmetricMatrix &L, double *x)
+{
+    PROFILE_SCOPE("cholesky_solve");
+    PROFILE_FLOPS(2.0 * L.size() * L.size());
+    PROFILE_BYTES(double(L.size()) * (L.size() + 1) / 2 * sizeof(double));
+    const VectorKernels &k = vector_kernels();
+    int panels = L.panels();
+    for (int K = 0; K < panels; K++) {
+        ConstMatrixView P = L.panel(K);
+        int kb = P.cols(), k0 = K * SYMMETRIC_TILE_SIZE;
+        double *xk = x + k0;
+        for (int j = 0; j < kb; j++) xk[j] = (xk[j] - k.dot(P[j], xk, j)) / P[j][j];
+        for (int i = kb; i < P.rows(); i++) xk[i] -= k.dot(P[i], xk, kb);
+    }
+    for (int K = panels - 1; K >= 0; K--) {
+        ConstMatrixView P = L.panel(K);
+        int kb = P.cols(), k0 = K * SYMMETRIC_TILE_SIZE;
+        double *xk = x + k0;
+        // x_K -= L21^T x_rest, затем x_K = L11^{-T} x_K
+        for (int i = kb; i < P.rows(); i++) k.axpy(kb, -xk[i], P[i], xk);
+        for (int j = kb - 1; j >= 0; j--) {
+            xk[j] /= P[j][j];
+            k.axpy(j, -xk[j], P[j], xk);
+        }
+    }
+}
+
+// Строка i, столбцы [j0, j1]: вызывает f(ptr, j, len) для кусков по панелям
+template<typename F>
+void for_row_segments(SymmetricMatrix &A, int i, int j0, int j1, F f)
+{
+    for (int J = j0 / SYMMETRIC_TILE_SIZE; J * SYMMETRIC_TILE_SIZE <= j1; J++) {
+        int base = J * SYMMETRIC_TILE_SIZE;
+        int first = std::max(j0, base), last = std::min(j1, base + SYMMETRIC_TILE_SIZE - 1);
+        f(A.row(i, J) + first - base, first, last - first + 1);
+    }
+}
+
+// Разложение A = P L D L^T P^T на месте с выбором ведущего элемента по
+// Банчу - Кауфману (как dsytf2 в LAPACK, нижний треугольник): D состоит
+// из блоков 1 x 1 и 2 x 2, L с единичной диагональью хранится под ними.
+// ipiv[k] = p - на шаге k переставлены k и p (блок 1 x 1); для блока
+// 2 x 2 в строках k, k + 1 ipiv[k] = ipiv[k + 1] = -(p + 1), переставлены
+// k + 1 и p. Подходит для любых невырожденных симметричных матриц.
+inline void LDLT_factor(SymmetricMatrix &A, std::vector<int> &ipiv)
+{
+    const double alpha = (1 + std::sqrt(17.0)) / 8;
+    int n = A.size();
+    ipiv.assign(n, 0);
+    // Столбцы k, k + 1 до обновления и новые столбцы L
+    std::vector<double> c0(n), c1(n), w0(n), w1(n);
+    int k = 0;
+    while (k < n) {
+        int kstep = 1, kp = k;
+        double absakk = std::fabs(A(k, k)), colmax = 0;
+        int imax = k;
+        for (int i = k + 1; i < n; i++) {
+            if (std::fabs(A(i, k)) > colmax) colmax = std::fabs(A(i, k)), imax = i;
+        }
+        if (std::max(absakk, colmax) == 0) throw "Matrix is singular";
+        if (absakk < alpha * colmax) {
+            double rowmax = 0;
+            for (int j = k; j < n; j++) {
+                if (j != imax) rowmax = std::max(rowmax, std::fabs(A(imax, j)));
+            }
+            if (absakk >= alpha * colmax * (colmax / rowmax)) kp = k;
+            else if (std::fabs(A(imax, imax)) >= alpha * rowmax) kp = imax;
+            else kp = imax, kstep = 2;
+        }
+        int kk = k + kstep - 1;
+        if (kp != kk) {
+            for (int i = kp + 1; i < n; i++) std::swap(A(i, kk), A(i, kp));
+            for (int j = kk + 1; j < kp; j++) std::swap(A(j, kk), A(kp, j));
+            std::swap(A(kk, kk), A(kp, kp));
+            if (kstep == 2) std::swap(A(k + 1, k), A(kp, k));
+        }
+        if (kstep == 1) {
+            // A22 -= c c^T / d, затем столбец L = c / d
+            double d = 1 / A(k, k);
+            for (int i = k + 1; i < n; i++) c0[i] = A(i, k);
+            for (int i = k + 1; i < n; i++) {
+                double coef = -d * c0[i];
+                for_row_segments(A, i, k + 1, i, [&](double *p, int j, int len) { axpy(len, coef, c0.data() + j, p); });
+                A(i, k) = d * c0[i];
+            }
+            ipiv[k] = kp;
+        } else {
+            // A22 -= [c0 c1] D^{-1} [c0 c1]^T = [c0 c1] [w0 w1]^T
+            double d21 = A(k + 1, k);
+            double d11 = A(k + 1, k + 1) / d21, d22 = A(k, k) / d21;
+            double t = 1 / (d11 * d22 - 1);
+            d21 = t / d21;
+            for (int j = k + 2; j < n; j++) {
+                c0[j] = A(j, k), c1[j] = A(j, k + 1);
+                w0[j] = d21 * (d11 * c0[j] - c1[j]);
+                w1[j] = d21 * (d22 * c1[j] - c0[j]);
+            }
+            for (int i = k + 2; i < n; i++) {
+                double f0 = -c0[i], f1 = -c1[i];
+                for_row_segments(A, i, k + 2, i, [&](double *p, int j, int len) {
+                    axpy(len, f0, w0.data() + j, p);
+                    axpy(len, f1, w1.data() + j, p);
+                });
+                A(i, k) = w0[i], A(i, k + 1) = w1[i];
+            }
+            ipiv[k] = ipiv[k + 1] = -(kp + 1);
+        }
+        k += kstep;
+    }
+}
+
+// Решение A x = b на месте по разложению LDLT_factor (как dsytrs в LAPACK)
+inline void LDLT_solve(const SymmetricMatrix &A, const std::vector<int> &ipiv, double *x)
+{
+    int n = A.size();
+    int k = 0;
+    while (k < n) {
+        if (ipiv[k] >= 0) {
+            std::swap(x[k], x[ipiv[k]]);
+            for (int i = k + 1; i < n; i++) x[i] -= A(i, k) * x[k];
+            x[k] /= A(k, k);
+            k += 1;
+        } else {
+            int kp = -ipiv[k] - 1;
+            std::swap(x[k + 1], x[kp]);
+            for (int i = k + 2; i < n; i++) x[i] -= A(i, k) * x[k] + A(i, k + 1) * x[k + 1];
+            double akm1k = A(k + 1, k);
+            double akm1 = A(k, k) / akm1k, ak = A(k + 1, k + 1) / akm1k;
+            double denom = akm1 * ak - 1;
+            double bkm1 = x[k] / akm1k, bk = x[k + 1] / akm1k;
+            x[k] = (ak * bkm1 - bk) / denom;
+            x[k + 1] = (akm1 * bk - bkm1) / denom;
+            k += 2;
+        }
+    }
+    k = n - 1;
+    while (k >= 0) {
+        if (ipiv[k] >= 0) {
+            for (int i = k + 1; i < n; i++) x[k] -= A(i, k) * x[i];
+            std::swap(x[k], x[ipiv[k]]);
+            k -= 1;
+        } else {
+            for (int i = k + 1; i < n; i++) {
+                x[k] -= A(i, k) * x[i];
+                x[k - 1] -= A(i, k - 1) * x[i];
+            }
+            std::swap(x[k], x[-ipiv[k] - 1]);
+            k -= 2;
+        }
+    }
+}
+
+// Способ разложения симметричной матрицы
+enum SymmetricMethod
+{
+    CHOLESKY,  // A = L L^T, A положительно определена
+    LDLT       // P A P^T = L D L^T по Банчу - Кауфману
+};
+
+// Разложение симметричной матрицы для многократного решения систем:
+// сначала пробуется разложение Холецкого, а если матрица оказалась не
+// положительно определённой - LDL^T. Хранит только нижний треугольник.
+class SymmetricFactorization
+{
+public:
+    SymmetricFactorization() : method_(CHOLESKY) {}
+
+    explicit SymmetricFactorization(ConstMatrixView A) { factor(A); }
+
+    // Разложение нижнего треугольника A (верхний не читается)
+    void factor(ConstMatrixView A)
+    {
+        factors_ = SymmetricMatrix(A);
+        ipiv_.clear();
+        method_ = CHOLESKY;
+        if (cholesky_factor(factors_)) return;
+        factors_ = SymmetricMatrix(A);
+        method_ = LDLT;
+        LDLT_factor(factors_, ipiv_);
+    }
+
+    int size() const { return factors_.size(); }
+    bool empty() const { return factors_.empty(); }
+    SymmetricMethod method() const { return method_; }
+    const SymmetricMatrix &factors() const { return factors_; }
+    const std::vector<int> &ipiv() const { return ipiv_; }
+
+    // Решение A x = b в буфер вызывающего (x может совпадать с b)
+    void solve(const std::vector<double> &b, std::vector<double> &x) const
+    {
+        if (int(b.size()) != size()) throw "Matrix and vector sizes doesnt match";
+        x = b;
+        if (method_ == CHOLESKY) cholesky_solve(factors_, x.data());
+        else LDLT_solve(factors_, ipiv_, x.data());
+    }
+
+    std::vector<double> solve(const std::vector<double> &b) const
+    {
+        std::vector<double> x;
+        solve(b, x);
+        return x;
+    }
+
+private:
+    SymmetricMatrix factors_;
+    std::vector<int> ipiv_;
+    SymmetricMethod method_;
+};
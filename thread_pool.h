@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing). У каждого потока своя
+// очередь: свои задачи он берёт с конца (LIFO, данные ещё в кэше), а
+// простаивающий поток забирает задачи с начала чужой очереди. Задачи,
+// порождённые внутри задачи, кладутся в очередь текущего потока, что
+// удобно для графов зависимостей: готовый преемник выполняется сразу.
+// Задачи, добавленные через submit_to, закреплены за потоком и не
+// перехватываются: так один и тот же поток раз за разом обрабатывает
+// одну и ту же часть данных (кэш и NUMA-узел остаются своими).
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int num_threads = 0)
+    {
+        if (num_threads <= 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+        for (int i = 0; i < num_threads; ++i) queues_.emplace_back(new Queue);
+        for (int i = 0; i < num_threads; ++i) threads_.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        sleep_cv_.notify_all();
+        for (auto &t : threads_) t.join();
+    }
+
+    int size() const { return int(threads_.size()); }
+
+    // Добавляет задачу в пул. Из рабочего потока - в его собственную очередь,
+    // извне - по кругу в очереди всех потоков.
+    void submit(std::function<void()> task)
+    {
+        ++pending_;
+        int id = (current_pool() == this) ? current_index() : int(next_queue_++ % queues_.size());
+        {
+            std::lock_guard<std::mutex> lock(queues_[id]->mutex);
+            queues_[id]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            ++queued_;
+        }
+        sleep_cv_.notify_one();
+    }
+
+    // Добавляет задачу, которую выполнит только поток worker
+    void submit_to(int worker, std::function<void()> task)
+    {
+        ++pending_;
+        Queue &q = *queues_[worker % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.pinned.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            ++q.pinned_queued;
+        }
+        // Будить нужно именно владельца очереди
+        sleep_cv_.notify_all();
+    }
+
+    // Ждёт завершения всех задач, включая порождённые ими. Если какая-то
+    // задача бросила исключение, оно пробрасывается здесь.
+    void wait()
+    {
+        {
+            std::unique_lock<std::mutex> lock(done_mutex_);
+            done_cv_.wait(lock, [this] { return pending_ == 0; });
+        }
+        std::exception_ptr error;
+        std::swap(error, error_);
+        if (error) std::rethrow_exception(error);
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        // Закреплённые задачи (submit_to) и их число; число меняется
+        // под sleep_mutex_ при добавлении, как queued_
+        std::deque<std::function<void()>> pinned;
+        std::atomic<int> pinned_queued{0};
+    };
+
+    static ThreadPool *&current_pool()
+    {
+        thread_local ThreadPool *pool = nullptr;
+        return pool;
+    }
+
+    static int &current_index()
+    {
+        thread_local int index = -1;
+        return index;
+    }
+
+    bool pop_pinned(int id, std::function<void()> &task)
+    {
+        Queue &q = *queues_[id];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.pinned.empty()) return false;
+        task = std::move(q.pinned.front());
+        q.pinned.pop_front();
+        --q.pinned_queued;
+        return true;
+    }
+
+    bool pop_local(int id, std::function<void()> &task)
+    {
+        std::lock_guard<std::mutex> lock(queues_[id]->mutex);
+        if (queues_[id]->tasks.empty()) return false;
+        task = std::move(queues_[id]->tasks.back());
+        queues_[id]->tasks.pop_back();
+        return true;
+    }
+
+    bool steal(int id, std::function<void()> &task)
+    {
+        int n = int(queues_.size());
+        for (int k = 1; k < n; ++k) {
+            Queue &q = *queues_[(id + k) % n];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty()) continue;
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void run(std::function<void()> &task)
+    {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            if (!error_) error_ = std::current_exception();
+        }
+        task = nullptr;
+        if (--pending_ == 0) {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done_cv_.notify_all();
+        }
+    }
+
+    void worker_loop(int id)
+    {
+        current_pool() = this;
+        current_index() = id;
+        std::function<void()> task;
+        Queue &own = *queues_[id];
+        while (true) {
+            if (pop_pinned(id, task)) {
+                run(task);
+                continue;
+            }
+            if (pop_local(id, task) || steal(id, task)) {
+                --queued_;
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.wait(lock, [this, &own] { return stop_ || queued_ > 0 || own.pinned_queued > 0; });
+            if (stop_ && queued_ <= 0 && own.pinned_queued <= 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<unsigned> next_queue_{0};
+
+    // Число перехватываемых задач в очередях; меняется под sleep_mutex_
+    // при добавлении, чтобы поток не уснул, пропустив новую задачу
+    std::atomic<int> queued_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    bool stop_ = false;
+
+    // Число добавленных, но ещё не выполненных задач
+    std::atomic<int> pending_{0};
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+    std::exception_ptr error_;
+};
@@ -0,0 +1,20 @@
+#include <iostream>
+
+#include "../lu.cpp"
+
+// Перевод матрицы из CSV в двоичный формат matrix_file.h
+// Запуск: ./csv2bin input.csv output.bin
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " input.csv output.bin" << std::endl;
+        return 1;
+    }
+    ThreadPool pool;
+    if (!convert_csv_to_binary(argv[1], argv[2], &pool)) return 1;
+
+    MappedMatrix A;
+    if (!A.open(argv[2], true)) return 1;
+    std::cout << argv[2] << ": " << A.rows() << " x " << A.cols() << std::endl;
+    return 0;
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "matrix.h"
+#include "vector_ops.h"
+
+// Выражения над векторами (expression templates). Операторы +, - и *
+// над std::vector и над матрицей на вектор ничего не вычисляют, а строят
+// лёгкое дерево выражения; оно вычисляется целиком, когда результат
+// присваивается вектору или передаётся в norm2 / max_norm. Тогда
+// norm2(F - A * x) - один проход по строкам A без промежуточных векторов,
+// а std::vector<double> r = F - A * x выделяет память только под r.
+// Узлы хранят указатели на векторы, поэтому выражение нельзя сохранять
+// в auto-переменную дольше, чем живут его операнды.
+
+// База всех выражений: E - конкретный узел с value_type, size() и operator[]
+template<typename E>
+class VectorExpression
+{
+public:
+    const E &self() const { return static_cast<const E &>(*this); }
+
+    // Вычисление в новый вектор
+    template<typename T>
+    operator std::vector<T>() const
+    {
+        static_assert(std::is_same<T, typename E::value_type>::value, "Vector expression type mismatch");
+        const E &e = self();
+        std::vector<T> result(e.size());
+        for (std::size_t i = 0; i < result.size(); ++i) result[i] = e[i];
+        return result;
+    }
+};
+
+// Лист дерева: ссылка на вектор
+template<typename T>
+class VectorTerminal : public VectorExpression<VectorTerminal<T>>
+{
+public:
+    typedef T value_type;
+
+    explicit VectorTerminal(const std::vector<T> &v) : v_(&v) {}
+
+    std::size_t size() const { return v_->size(); }
+    T operator[](std::size_t i) const { return (*v_)[i]; }
+
+private:
+    const std::vector<T> *v_;
+};
+
+struct VectorPlus
+{
+    template<typename T>
+    static T apply(T a, T b) { return a + b; }
+};
+
+struct VectorMinus
+{
+    template<typename T>
+    static T apply(T a, T b) { return a - b; }
+};
+
+// Поэлементная операция Op над двумя выражениями одной длины
+template<typename L, typename R, typename Op>
+class VectorBinary : public VectorExpression<VectorBinary<L, R, Op>>
+{
+public:
+    typedef typename L::value_type value_type;
+    static_assert(std::is_same<value_type, typename R::value_type>::value, "Vector expression type mismatch");
+
+    VectorBinary(const L &l, const R &r) : l_(l), r_(r)
+    {
+        if (l.size() != r.size()) throw "Vectors sizes doesnt match";
+    }
+
+    std::size_t size() const { return l_.size(); }
+    value_type operator[](std::size_t i) const { return Op::apply(l_[i], r_[i]); }
+
+private:
+    L l_;
+    R r_;
+};
+
+// Выражение, умноженное на число
+template<typename E>
+class VectorScaled : public VectorExpression<VectorScaled<E>>
+{
+public:
+    typedef typename E::value_type value_type;
+
+    VectorScaled(value_type alpha, const E &e) : alpha_(alpha), e_(e) {}
+
+    std::size_t size() const { return e_.size(); }
+    value_type operator[](std::size_t i) const { return alpha_ * e_[i]; }
+
+private:
+    value_type alpha_;
+    E e_;
+};
+
+// Произведение плотной матрицы на вектор: элемент i - скалярное
+// произведение строки i на x. x не должен быть вектором, в который
+// записывается результат (присваивание в новый вектор это гарантирует).
+template<typename T>
+class MatrixVectorProduct : public VectorExpression<MatrixVectorProduct<T>>
+{
+public:
+    typedef T value_type;
+
+    MatrixVectorProduct(BasicMatrixView<const T> A, const std::vector<T> &x)
+        : A_(A), x_(x.data()), dot_(nullptr)
+    {
+        if (A.cols() != int(x.size())) throw "Matrix and vector sizes doesnt match";
+        if constexpr (std::is_same<T, double>::value) dot_ = vector_kernels().dot;
+    }
+
+    std::size_t size() const { return std::size_t(A_.rows()); }
+
+    T operator[](std::size_t i) const
+    {
+        const T *row = A_[int(i)];
+        if constexpr (std::is_same<T, double>::value) {
+            return dot_(row, x_, A_.cols());
+        } else {
+            T sum = 0;
+            for (int j = 0; j < A_.cols(); ++j) sum += row[j] * x_[j];
+            return sum;
+        }
+    }
+
+private:
+    BasicMatrixView<const T> A_;
+    const T *x_;
+    double (*dot_)(const double *, const double *, int);
+};
+
+namespace vector_expr_detail
+{
+
+// Операнд выражения: std::vector или другое выражение
+template<typename V>
+struct Operand
+{
+    static const bool value = false;
+};
+
+template<typename T>
+struct Operand<std::vector<T>>
+{
+    static const bool value = true;
+    typedef VectorTerminal<T> type;
+    static type wrap(const std::vector<T> &v) { return type(v); }
+};
+
+template<typename V>
+struct ExpressionOperand
+{
+    static const bool value = std::is_base_of<VectorExpression<V>, V>::value;
+    typedef V type;
+    static const V &wrap(const V &e) { return e; }
+};
+
+template<typename V>
+using OperandTraits = typename std::conditional<Operand<V>::value, Operand<V>, ExpressionOperand<V>>::type;
+
+template<typename L, typename R>
+using EnableIfOperands = typename std::enable_if<OperandTraits<L>::value && OperandTraits<R>::value>::type;
+
+} // namespace vector_expr_detail
+
+template<typename L, typename R, typename = vector_expr_detail::EnableIfOperands<L, R>>
+VectorBinary<typename vector_expr_detail::OperandTraits<L>::type, typename vector_expr_detail::OperandTraits<R>::type, VectorPlus>
+operator+(const L &l, const R &r)
+{
+    using namespace vector_expr_detail;
+    return {OperandTraits<L>::wrap(l), OperandTraits<R>::wrap(r)};
+}
+
+template<typename L, typename R, typename = vector_expr_detail::EnableIfOperands<L, R>>
+VectorBinary<typename vector_expr_detail::OperandTraits<L>::type, typename vector_expr_detail::OperandTraits<R>::type, VectorMinus>
+operator-(const L &l, const R &r)
+{
+    using namespace vector_expr_detail;
+    return {OperandTraits<L>::wrap(l), OperandTraits<R>::wrap(r)};
+}
+
+// alpha * v и v * alpha
+template<typename V, typename = vector_expr_detail::EnableIfOperands<V, V>>
+VectorScaled<typename vector_expr_detail::OperandTraits<V>::type>
+operator*(typename vector_expr_detail::OperandTraits<V>::type::value_type alpha, const V &v)
+{
+    return {alpha, vector_expr_detail::OperandTraits<V>::wrap(v)};
+}
+
+template<typename V, typename = vector_expr_detail::EnableIfOperands<V, V>>
+VectorScaled<typename vector_expr_detail::OperandTraits<V>::type>
+operator*(const V &v, typename vector_expr_detail::OperandTraits<V>::type::value_type alpha)
+{
+    return {alpha, vector_expr_detail::OperandTraits<V>::wrap(v)};
+}
+
+// Произведение матрицы на вектор
+template<typename T>
+MatrixVectorProduct<T> operator*(const BasicMatrix<T> &A, const std::vector<T> &x)
+{
+    return MatrixVectorProduct<T>(A.view(), x);
+}
+
+// Вычисление в буфер вызывающего без выделения памяти (если ёмкости
+// хватает). out может входить в выражение поэлементно (x = x + tau * r),
+// но не как вектор, умножаемый на матрицу.
+template<typename E, typename T>
+void evaluate(const VectorExpression<E> &expression, std::vector<T> &out)
+{
+    const E &e = expression.self();
+    std::size_t n = e.size();
+    out.resize(n);
+    for (std::size_t i = 0; i < n; ++i) out[i] = e[i];
+}
+
+// Вторая норма выражения за один проход
+template<typename E>
+double norm2(const VectorExpression<E> &expression)
+{
+    const E &e = expression.self();
+    double sum = 0;
+    for (std::size_t i = 0; i < e.size(); ++i) {
+        double v = e[i];
+        sum += v * v;
+    }
+    return std::sqrt(sum);
+}
+
+// Максимум модуля элементов выражения
+template<typename E>
+double max_norm(const VectorExpression<E> &expression)
+{
+    const E &e = expression.self();
+    double max = 0;
+    for (std::size_t i = 0; i < e.size(); ++i) max = std::max(max, double(std::fabs(e[i])));
+    return max;
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#include "matrix.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VECTOR_OPS_X86 1
+#endif
+
+// Векторные ядра для итерационных методов: скалярный вариант и варианты на
+// AVX2/FMA и AVX-512. Вариант выбирается один раз при первом вызове по
+// возможностям процессора, поэтому программа собирается без -march.
+// Строки Matrix выровнены по MATRIX_ALIGNMENT, так что загрузки строк не
+// пересекают строки кэша; векторы могут быть выровнены произвольно.
+
+namespace vector_ops_detail
+{
+
+inline double dot_scalar(const double *a, const double *b, int n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+inline double max_abs_scalar(const double *a, int n)
+{
+    double max = 0;
+    for (int i = 0; i < n; ++i) max = std::max(max, std::fabs(a[i]));
+    return max;
+}
+
+inline void axpy_scalar(int n, double alpha, const double *x, double *y)
+{
+    for (int i = 0; i < n; ++i) y[i] += alpha * x[i];
+}
+
+inline void add_scalar(int n, const double *x, const double *y, double *w)
+{
+    for (int i = 0; i < n; ++i) w[i] = x[i] + y[i];
+}
+
+inline void sub_scalar(int n, const double *x, const double *y, double *w)
+{
+    for (int i = 0; i < n; ++i) w[i] = x[i] - y[i];
+}
+
+#ifdef VECTOR_OPS_X86
+
+__attribute__((target("avx2,fma"))) inline double dot_avx2(const double *a, const double *b, int n)
+{
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), s1);
+    }
+    for (; i + 4 <= n; i += 4) {
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+    }
+    s0 = _mm256_add_pd(s0, s1);
+    __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+    double s = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    for (; i < n; ++i) s += a[i] * b[i];
+    return s;
+}
+
+__attribute__((target("avx2"))) inline double max_abs_avx2(const double *a, int n)
+{
+    const __m256d mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    __m256d m = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) m = _mm256_max_pd(m, _mm256_and_pd(_mm256_loadu_pd(a + i), mask));
+    __m128d h = _mm_max_pd(_mm256_castpd256_pd128(m), _mm256_extractf128_pd(m, 1));
+    double max = _mm_cvtsd_f64(_mm_max_sd(h, _mm_unpackhi_pd(h, h)));
+    for (; i < n; ++i) max = std::max(max, std::fabs(a[i]));
+    return max;
+}
+
+__attribute__((target("avx2,fma"))) inline void axpy_avx2(int n, double alpha, const double *x, double *y)
+{
+    __m256d a = _mm256_set1_pd(alpha);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    for (; i < n; ++i) y[i] += alpha * x[i];
+}
+
+__attribute__((target("avx2"))) inline void add_avx2(int n, const double *x, const double *y, double *w)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(w + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    for (; i < n; ++i) w[i] = x[i] + y[i];
+}
+
+__attribute__((target("avx2"))) inline void sub_avx2(int n, const double *x, const double *y, double *w)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(w + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+    for (; i < n; ++i) w[i] = x[i] - y[i];
+}
+
+__attribute__((target("avx512f"))) inline double dot_avx512(const double *a, const double *b, int n)
+{
+    __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), s1);
+    }
+    if (i < n) {
+        // Хвост обрабатывается маскированной загрузкой
+        for (; i < n; i += 8) {
+            __mmask8 m = (n - i >= 8) ? __mmask8(0xff) : __mmask8((1u << (n - i)) - 1);
+            s0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i), s0);
+        }
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+}
+
+__attribute__((target("avx512f"))) inline double max_abs_avx512(const double *a, int n)
+{
+    __m512d m = _mm512_setzero_pd();
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 k = (n - i >= 8) ? __mmask8(0xff) : __mmask8((1u << (n - i)) - 1);
+        m = _mm512_max_pd(m, _mm512_abs_pd(_mm512_maskz_loadu_pd(k, a + i)));
+    }
+    return _mm512_reduce_max_pd(m);
+}
+
+__attribute__((target("avx512f"))) inline void axpy_avx512(int n, double alpha, const double *x, double *y)
+{
+    __m512d a = _mm512_set1_pd(alpha);
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 k = (n - i >= 8) ? __mmask8(0xff) : __mmask8((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd(y + i, k, _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(k, x + i), _mm512_maskz_loadu_pd(k, y + i)));
+    }
+}
+
+__attribute__((target("avx512f"))) inline void add_avx512(int n, const double *x, const double *y, double *w)
+{
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 k = (n - i >= 8) ? __mmask8(0xff) : __mmask8((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd(w + i, k, _mm512_add_pd(_mm512_maskz_loadu_pd(k, x + i), _mm512_maskz_loadu_pd(k, y + i)));
+    }
+}
+
+__attribute__((target("avx512f"))) inline void sub_avx512(int n, const double *x, const double *y, double *w)
+{
+    for (int i = 0; i < n; i += 8) {
+        __mmask8 k = (n - i >= 8) ? __mmask8(0xff) : __mmask8((1u << (n - i)) - 1);
+        _mm512_mask_storeu_pd(w + i, k, _mm512_sub_pd(_mm512_maskz_loadu_pd(k, x + i), _mm512_maskz_loadu_pd(k, y + i)));
+    }
+}
+
+#endif
+
+} // namespace vector_ops_detail
+
+// Таблица ядер, выбранных под текущий процессор
+struct VectorKernels
+{
+    const char *name;
+    double (*dot)(const double *a, const double *b, int n);
+    double (*max_abs)(const double *a, int n);
+    void (*axpy)(int n, double alpha, const double *x, double *y);
+    void (*add)(int n, const double *x, const double *y, double *w);
+    void (*sub)(int n, const double *x, const double *y, double *w);
+};
+
+inline VectorKernels select_vector_kernels()
+{
+    using namespace vector_ops_detail;
+#ifdef VECTOR_OPS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return VectorKernels{"avx512", dot_avx512, max_abs_avx512, axpy_avx512, add_avx512, sub_avx512};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return VectorKernels{"avx2", dot_avx2, max_abs_avx2, axpy_avx2, add_avx2, sub_avx2};
+    }
+#endif
+    return VectorKernels{"scalar", dot_scalar, max_abs_scalar, axpy_scalar, add_scalar, sub_scalar};
+}
+
+inline const VectorKernels &vector_kernels()
+{
+    static const VectorKernels kernels = select_vector_kernels();
+    return kernels;
+}
+
+// Скалярное произведение
+inline double dot(const double *a, const double *b, int n)
+{
+    return vector_kernels().dot(a, b, n);
+}
+
+// Максимум модуля элементов
+inline double max_abs(const double *a, int n)
+{
+    return vector_kernels().max_abs(a, n);
+}
+
+// y += alpha * x
+inline void axpy(int n, double alpha, const double *x, double *y)
+{
+    vector_kernels().axpy(n, alpha, x, y);
+}
+
+// w = x + y (w может совпадать с x или y)
+inline void vector_add(int n, const double *x, const double *y, double *w)
+{
+    vector_kernels().add(n, x, y, w);
+}
+
+// w = x - y (w может совпадать с x или y)
+inline void vector_sub(int n, const double *x, const double *y, double *w)
+{
+    vector_kernels().sub(n, x, y, w);
+}
+
+// y = A x в буфер вызывающего
+inline void gemv(ConstMatrixView A, const double *x, double *y)
+{
+    const VectorKernels &k = vector_kernels();
+    for (int i = 0; i < A.rows(); ++i) y[i] = k.dot(A[i], x, A.cols());
+}
+
+// Невязка r = f - A x в буфер вызывающего (r не должен совпадать с x)
+inline void residual(ConstMatrixView A, const double *x, const double *f, double *r)
+{
+    const VectorKernels &k = vector_kernels();
+    for (int i = 0; i < A.rows(); ++i) r[i] = f[i] - k.dot(A[i], x, A.cols());
+}
+
+// Обобщённые варианты для других типов элементов
+template<typename T>
+void gemv(BasicMatrixView<const T> A, const T *x, T *y)
+{
+    for (int i = 0; i < A.rows(); ++i) {
+        const T *row = A[i];
+        T sum = 0;
+        for (int j = 0; j < A.cols(); ++j) sum += row[j] * x[j];
+        y[i] = sum;
+    }
+}